@@ -0,0 +1,255 @@
+#include "AlsaCapture.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+AlsaCapture::AlsaCapture(std::string device)
+    : device(std::move(device)), pcm(nullptr), channels(0), sampleRate(0), periodFrames(0), bufferFrames(0),
+      wakeFrames(0), appliedWakeFrames(0), pcmFdCount(0), wakePipe{-1, -1}, stopThread(false), overruns(0) {
+}
+
+AlsaCapture::~AlsaCapture() {
+    close();
+}
+
+bool AlsaCapture::open(const CaptureFormat& format, int periodMs, BlockCallback callback) {
+    channels = format.channels;
+    sampleRate = format.sampleRate;
+    this->callback = std::move(callback);
+
+    int err = snd_pcm_open(&pcm, device.c_str(), SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK);
+    if (err < 0) {
+        std::cerr << "Failed to open ALSA device " << device << ": " << snd_strerror(err) << std::endl;
+        pcm = nullptr;
+        return false;
+    }
+
+    if (!setHardwareParams(format, periodMs)) {
+        close();
+        return false;
+    }
+
+    // Wake up once per period, the thread drains everything available each time
+    snd_pcm_sw_params_t* swParams;
+    snd_pcm_sw_params_alloca(&swParams);
+    snd_pcm_sw_params_current(pcm, swParams);
+    snd_pcm_sw_params_set_avail_min(pcm, swParams, periodFrames);
+    err = snd_pcm_sw_params(pcm, swParams);
+    wakeFrames = appliedWakeFrames = periodFrames;
+    if (err < 0) {
+        std::cerr << "Failed to set ALSA software params: " << snd_strerror(err) << std::endl;
+        close();
+        return false;
+    }
+
+    if (pipe(wakePipe) != 0) {
+        std::cerr << "Failed to create wake pipe\n";
+        close();
+        return false;
+    }
+    // start() drains it, which must not block when it is empty
+    fcntl(wakePipe[0], F_SETFL, fcntl(wakePipe[0], F_GETFL) | O_NONBLOCK);
+
+    pcmFdCount = snd_pcm_poll_descriptors_count(pcm);
+    pollFds.resize(pcmFdCount + 1);
+    snd_pcm_poll_descriptors(pcm, pollFds.data(), pcmFdCount);
+    pollFds[pcmFdCount] = {wakePipe[0], POLLIN, 0};
+    return true;
+}
+
+bool AlsaCapture::setHardwareParams(const CaptureFormat& format, int periodMs) {
+    snd_pcm_hw_params_t* hwParams;
+    snd_pcm_hw_params_alloca(&hwParams);
+    snd_pcm_hw_params_any(pcm, hwParams);
+
+    int err = snd_pcm_hw_params_set_access(pcm, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+    if (err < 0) {
+        std::cerr << "ALSA device " << device << " does not support mmap access: " << snd_strerror(err)
+                  << " (try plug:" << device << ")" << std::endl;
+        return false;
+    }
+
+    err = snd_pcm_hw_params_set_format(pcm, hwParams, SND_PCM_FORMAT_S16_LE);
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_channels(pcm, hwParams, format.channels);
+    }
+    unsigned int rate = format.sampleRate;
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_rate_near(pcm, hwParams, &rate, nullptr);
+    }
+    if (err < 0) {
+        std::cerr << "Unsupported capture format: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    if (rate != static_cast<unsigned int>(format.sampleRate)) {
+        std::cerr << "Sample rate " << format.sampleRate << " not supported, device uses " << rate << std::endl;
+        return false;
+    }
+
+    periodFrames = static_cast<snd_pcm_uframes_t>(format.sampleRate) * periodMs / 1000;
+    snd_pcm_hw_params_set_period_size_near(pcm, hwParams, &periodFrames, nullptr);
+    // Capture latency depends on the period only, so a generous buffer costs
+    // nothing and leaves room for longer wake intervals
+    bufferFrames = std::max<snd_pcm_uframes_t>(periodFrames * 4, format.sampleRate / 2);
+    snd_pcm_hw_params_set_buffer_size_near(pcm, hwParams, &bufferFrames);
+
+    err = snd_pcm_hw_params(pcm, hwParams);
+    if (err < 0) {
+        std::cerr << "Failed to set ALSA hardware params: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    snd_pcm_hw_params_get_period_size(hwParams, &periodFrames, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hwParams, &bufferFrames);
+    return true;
+}
+
+bool AlsaCapture::start() {
+    if (!pcm || thread.joinable()) return false;
+
+    int err = snd_pcm_prepare(pcm);
+    if (err >= 0) {
+        err = snd_pcm_start(pcm);
+    }
+    if (err < 0) {
+        std::cerr << "Error starting ALSA capture: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+
+    // The wakeup of a previous stop() would end the new thread at once
+    char drained[16];
+    while (read(wakePipe[0], drained, sizeof(drained)) > 0) {
+    }
+
+    stopThread = false;
+    thread = std::thread(&AlsaCapture::captureThread, this);
+    return true;
+}
+
+void AlsaCapture::stop() {
+    if (!thread.joinable()) return;
+
+    stopThread = true;
+    char byte = 0;
+    if (write(wakePipe[1], &byte, 1) < 0) {
+        std::cerr << "Failed to wake capture thread\n";
+    }
+    thread.join();
+    snd_pcm_drop(pcm);
+}
+
+void AlsaCapture::close() {
+    stop();
+    if (pcm) {
+        snd_pcm_close(pcm);
+        pcm = nullptr;
+    }
+    for (int& fd : wakePipe) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    pollFds.clear();
+}
+
+bool AlsaCapture::setWakeInterval(int ms) {
+    if (!pcm) return false;
+    snd_pcm_uframes_t frames = periodFrames;
+    if (ms > 0) {
+        // Keep half the buffer free so a late wakeup does not overrun
+        frames = std::clamp<snd_pcm_uframes_t>(static_cast<snd_pcm_uframes_t>(sampleRate) * ms / 1000,
+                                               periodFrames, std::max(periodFrames, bufferFrames / 2));
+    }
+    wakeFrames = frames;
+    return true;
+}
+
+void AlsaCapture::applyWakeInterval() {
+    snd_pcm_uframes_t frames = wakeFrames;
+    if (frames == appliedWakeFrames) return;
+
+    snd_pcm_sw_params_t* swParams;
+    snd_pcm_sw_params_alloca(&swParams);
+    snd_pcm_sw_params_current(pcm, swParams);
+    snd_pcm_sw_params_set_avail_min(pcm, swParams, frames);
+    int err = snd_pcm_sw_params(pcm, swParams);
+    if (err < 0) {
+        std::cerr << "Failed to change ALSA wake interval: " << snd_strerror(err) << std::endl;
+    }
+    appliedWakeFrames = frames;
+}
+
+bool AlsaCapture::recover(int err) {
+    if (err == -EPIPE) {
+        ++overruns;
+    }
+    err = snd_pcm_recover(pcm, err, 1);
+    if (err >= 0) {
+        err = snd_pcm_start(pcm);
+    }
+    if (err < 0) {
+        std::cerr << "ALSA capture failed: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void AlsaCapture::captureThread() {
+    bool failed = false;
+    while (!stopThread && !failed) {
+        applyWakeInterval();
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ALSA poll failed: " << std::strerror(errno) << std::endl;
+            failed = true;
+            break;
+        }
+        if (pollFds[pcmFdCount].revents & POLLIN) {
+            break;
+        }
+
+        unsigned short revents = 0;
+        snd_pcm_poll_descriptors_revents(pcm, pollFds.data(), pcmFdCount, &revents);
+        if (revents & POLLERR) {
+            failed = !recover(snd_pcm_state(pcm) == SND_PCM_STATE_XRUN ? -EPIPE : -ESTRPIPE);
+            continue;
+        }
+        if (!(revents & POLLIN)) continue;
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            failed = !recover(static_cast<int>(avail));
+            continue;
+        }
+
+        // The readable region may wrap around the ring buffer, so it can take two mmap_begin calls
+        while (avail > 0) {
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t frames = avail;
+            int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+            if (err < 0) {
+                failed = !recover(err);
+                break;
+            }
+
+            const short* data = reinterpret_cast<const short*>(
+                static_cast<const char*>(areas[0].addr) + areas[0].first / 8 + offset * areas[0].step / 8);
+            if (callback) callback(data, frames * channels);
+
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+            if (committed < 0 || static_cast<snd_pcm_uframes_t>(committed) != frames) {
+                failed = !recover(committed < 0 ? static_cast<int>(committed) : -EPIPE);
+                break;
+            }
+            avail -= frames;
+        }
+    }
+
+    if (failed) {
+        reportError("ALSA device " + device + " failed");
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef COURSE_ALSACAPTURE_H
+#define COURSE_ALSACAPTURE_H
+
+#include "CaptureBackend.h"
+#include <alsa/asoundlib.h>
+#include <poll.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ALSA capture in mmap mode. The capture thread sleeps in poll() on the PCM
+// descriptors and hands each readable region of the ring buffer straight to
+// the callback, without an intermediate copy. Any PCM name works, e.g.
+// "default", "hw:Loopback,1" or "null" for runs without hardware.
+class AlsaCapture : public CaptureBackend {
+public:
+    explicit AlsaCapture(std::string device = "default");
+    ~AlsaCapture() override;
+
+    bool open(const CaptureFormat& format, int periodMs, BlockCallback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    const char* name() const override { return "alsa"; }
+    uint64_t getOverruns() const override { return overruns; }
+    bool setWakeInterval(int ms) override;
+
+private:
+    bool setHardwareParams(const CaptureFormat& format, int periodMs);
+    bool recover(int err);
+    void applyWakeInterval();
+    void captureThread();
+
+    std::string device;
+    snd_pcm_t* pcm;
+    int channels;
+    int sampleRate;
+    snd_pcm_uframes_t periodFrames;
+    snd_pcm_uframes_t bufferFrames;
+    std::atomic<snd_pcm_uframes_t> wakeFrames;   // requested avail_min, applied by the capture thread
+    snd_pcm_uframes_t appliedWakeFrames;
+    BlockCallback callback;
+
+    std::vector<pollfd> pollFds;
+    int pcmFdCount;
+    int wakePipe[2];
+
+    std::thread thread;
+    std::atomic<bool> stopThread;
+    std::atomic<uint64_t> overruns;
+};
+
+#endif //COURSE_ALSACAPTURE_H
@@ -1,212 +1,895 @@
 #include "AudioRecorder.h"
+#include "QualityMeter.h"
+#include "SilenceSplitter.h"
+#include "WavWriter.h"
 #include <iostream>
-#include <fstream>
-#include <thread>
 #include <chrono>
 #include <format>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 AudioRecorder* AudioRecorder::instance = nullptr;
+#ifndef _WIN32
+int AudioRecorder::signalPipe[2] = {-1, -1};
+#endif
+
+namespace {
+    const auto USAGE_INTERVAL = std::chrono::seconds(10);
+    const double WAKE_FRACTION = 0.5;  // of the threshold, so onsets wake power saving early
+
+    // Peak of every stride-th frame
+    int peakOf(const short* samples, size_t count, int channels, int stride) {
+        int peak = 0;
+        size_t step = static_cast<size_t>(channels) * stride;
+        for (size_t frame = 0; frame + channels <= count; frame += step) {
+            for (int c = 0; c < channels; ++c) {
+                peak = std::max(peak, std::abs((int)samples[frame + c]));
+            }
+        }
+        return peak;
+    }
+
+    // CPU time of the whole process, and how often its threads blocked and
+    // woke up again where the OS counts that
+    bool readProcessUsage(uint64_t& cpuUs, uint64_t& wakeups) {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return false;
+        auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+        cpuUs = (ticks(kernel) + ticks(user)) / 10;
+        wakeups = 0;
+        return false;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return false;
+        cpuUs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ull + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+        wakeups = usage.ru_nvcsw;
+        return true;
+#endif
+    }
+}
 
 AudioRecorder::AudioRecorder(int sampleRate, int channels, int bitsPerSample, int recordSeconds)
-    : sampleRate(sampleRate), channels(channels), bitsPerSample(bitsPerSample),
-      recordSeconds(recordSeconds), waveInBuffer(nullptr),
-      isRecording(false), stopRecording(false), isRecordStart(false), running(true) {
-    NUMPTS = sampleRate * channels * recordSeconds;
+    : AudioRecorder([&] {
+          RecorderConfig defaults;
+          defaults.sampleRate = sampleRate;
+          defaults.channels = channels;
+          defaults.bitsPerSample = bitsPerSample;
+          defaults.recordSeconds = recordSeconds;
+          return defaults;
+      }()) {
 }
 
-AudioRecorder::AudioContext::AudioContext() : hWaveIn(nullptr) {
-    ZeroMemory(&wfx, sizeof(WAVEFORMATEX));
+AudioRecorder::AudioRecorder(const RecorderConfig& config)
+    : config(config), pendingConfig(config), configPending(false),
+      isRecording(false), stopRecording(false), isRecordStart(false), running(false),
+      armed(true), threshold(config.threshold), logLevels(true), levelSequence(0),
+      keywordHeard(false), quietMs(0), powerSaving(false), silentMs(0), latestLevel(0.0) {
+    if (this->config.backend.empty()) {
+        this->config.backend = pendingConfig.backend = defaultCaptureBackend();
+    }
+    meterBlockSamples = static_cast<size_t>(config.sampleRate) * config.bufferMs / 1000 * config.channels;
+    meterBlock.reserve(meterBlockSamples);
+}
+
+AudioRecorder::~AudioRecorder() {
+    stop();
+#ifndef _WIN32
+    if (signalThread.joinable()) {
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        // 0 is no signal, it only ends the watcher
+        unsigned char quit = 0;
+        (void)!write(signalPipe[1], &quit, 1);
+        signalThread.join();
+    }
+#endif
+    if (instance == this) instance = nullptr;
 }
 
 void AudioRecorder::run() {
-    std::signal(SIGINT, signalHandlerStatic);
-    instance = this;
+    handleSignals();
+    running = true;
 
     std::cout << "Program started. Press Ctrl+C to exit\n";
     monitorMicLevel();
 }
 
-void AudioRecorder::signalHandlerStatic(int signal) {
-    if (instance) instance->signalHandler(signal);
+void AudioRecorder::handleSignals() {
+    instance = this;
+#ifdef _WIN32
+    // Console control handlers run on a thread of their own, so this one may stop directly
+    SetConsoleCtrlHandler([](DWORD type) -> BOOL {
+        if (type != CTRL_C_EVENT && type != CTRL_BREAK_EVENT && type != CTRL_CLOSE_EVENT) return FALSE;
+        signalHandlerStatic(SIGINT);
+        return TRUE;
+    }, TRUE);
+#else
+    if (signalPipe[0] < 0) {
+        if (pipe(signalPipe) != 0) {
+            std::cerr << "Failed to create the signal pipe\n";
+            return;
+        }
+        for (int fd : signalPipe) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        // A full pipe already holds a pending stop, the handler must never block
+        fcntl(signalPipe[1], F_SETFL, fcntl(signalPipe[1], F_GETFL) | O_NONBLOCK);
+    }
+    if (!signalThread.joinable()) {
+        signalThread = std::thread(&AudioRecorder::watchSignals, this);
+    }
+    std::signal(SIGINT, signalHandlerStatic);
+    std::signal(SIGTERM, signalHandlerStatic);
+#endif
 }
 
-void AudioRecorder::signalHandler(int signal) {
-    if (signal == SIGINT) {
-        std::cout << "\nCtrl+C received. Exiting...\n";
+void AudioRecorder::start() {
+    if (running) {
+        std::cout << "AudioRecorder already running\n";
+        return;
+    }
+
+    instance = this;
+    running = true;
+    workerThread = std::thread(&AudioRecorder::monitorMicLevel, this);
+    std::cout << "AudioRecorder started in separate thread\n";
+}
+
+void AudioRecorder::stop() {
+    requestStop();
+
+    if (workerThread.joinable()) {
+        workerThread.join();
+        std::cout << "AudioRecorder stopped\n";
+    }
+}
+
+bool AudioRecorder::isRunning() const {
+    return running.load();
+}
+
+void AudioRecorder::requestStop() {
+    {
+        std::lock_guard<std::mutex> lock(runMutex);
         running = false;
     }
+    runCV.notify_all();
+    {
+        // getNextLevel() checks running under levelMutex
+        std::lock_guard<std::mutex> lock(levelMutex);
+    }
+    levelCV.notify_all();
 }
 
-std::string AudioRecorder::getCurrentDateTimeString() {
-    auto now = std::chrono::system_clock::now();
-    return std::format("{:%Y-%m-%d_%H-%M-%S}", now);
+void AudioRecorder::waitUntilStopped() {
+    std::unique_lock<std::mutex> lock(runMutex);
+    runCV.wait(lock, [this] { return !running; });
 }
 
-void AudioRecorder::saveToWav(const std::string& filename, short* data, int dataSize) {
-    std::ofstream file(filename, std::ios::binary);
+void AudioRecorder::setBackend(std::unique_ptr<CaptureBackend> customBackend) {
+    RecorderConfig next = getConfig();
+    next.backend = customBackend ? customBackend->name() : defaultCaptureBackend();
+    backendSpec = next.backend;
+    backend = std::move(customBackend);
+    applyConfig(next);
+}
 
-    file << "RIFF";
-    int chunkSize = 36 + dataSize;
-    file.write((char*)&chunkSize, 4);
-    file << "WAVE";
+void AudioRecorder::setLevelLogging(bool enabled) {
+    logLevels = enabled;
+}
 
-    file << "fmt ";
-    int subchunk1Size = 16;
-    file.write((char*)&subchunk1Size, 4);
-    short audioFormat = 1;
-    file.write((char*)&audioFormat, 2);
-    file.write((char*)&channels, 2);
-    file.write((char*)&sampleRate, 4);
-    int byteRate = sampleRate * channels * bitsPerSample / 8;
-    file.write((char*)&byteRate, 4);
-    short blockAlign = channels * bitsPerSample / 8;
-    file.write((char*)&blockAlign, 2);
-    file.write((char*)&bitsPerSample, 2);
+void AudioRecorder::applyConfig(const RecorderConfig& newConfig) {
+    std::string changes;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        pendingConfig = newConfig;
+        if (pendingConfig.backend.empty()) {
+            pendingConfig.backend = defaultCaptureBackend();
+        }
+        if (running) {
+            configPending = true;
+            return;
+        }
+        changes = config.diff(pendingConfig);
+        config = pendingConfig;
+    }
 
-    file << "data";
-    file.write((char*)&dataSize, 4);
-    file.write((char*)data, dataSize);
+    meterBlockSamples = static_cast<size_t>(config.sampleRate) * config.bufferMs / 1000 * config.channels;
+    threshold = config.threshold;
+    configApplied(changes);
 }
 
-void AudioRecorder::recordingThread() {
-    WAVEFORMATEX format{};
-    format.wFormatTag = WAVE_FORMAT_PCM;
-    format.nChannels = channels;
-    format.wBitsPerSample = bitsPerSample;
-    format.nSamplesPerSec = sampleRate;
-    format.nAvgBytesPerSec = sampleRate * channels * bitsPerSample / 8;
-    format.nBlockAlign = channels * bitsPerSample / 8;
+RecorderConfig AudioRecorder::getConfig() const {
+    std::lock_guard<std::mutex> lock(configMutex);
+    return pendingConfig;
+}
 
-    HWAVEIN hWaveIn;
-    WAVEHDR waveInHdr;
+void AudioRecorder::applyPendingConfig() {
+    // Never wait on the capture thread, a busy lock just defers the change by one packet
+    std::unique_lock<std::mutex> lock(configMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+
+    RecorderConfig next = pendingConfig;
+    configPending = false;
+    lock.unlock();
+
+    if (config.needsRestart(next)) {
+        std::cout << "Capture settings changed, they apply on the next start\n";
+        next.backend = config.backend;
+        next.sampleRate = config.sampleRate;
+        next.channels = config.channels;
+        next.bitsPerSample = config.bitsPerSample;
+        next.periodMs = config.periodMs;
+        next.trigger = config.trigger;
+        next.kwsModel = config.kwsModel;
+        next.kwsKeywords = config.kwsKeywords;
+        next.journal = config.journal;
+        next.exportTo = config.exportTo;
+        next.exportSpool = config.exportSpool;
+        next.exportConcurrency = config.exportConcurrency;
+    }
 
-    waveInBuffer = new short[NUMPTS];
-    ZeroMemory(waveInBuffer, NUMPTS * sizeof(short));
+    std::string changes = config.diff(next);
+    config = next;
 
-    if (waveInOpen(&hWaveIn, WAVE_MAPPER, &format, 0L, 0L, WAVE_FORMAT_DIRECT) != MMSYSERR_NOERROR) {
-        std::cerr << "Error opening recording device!\n";
-        isRecording = false;
-        return;
+    meterBlockSamples = static_cast<size_t>(config.sampleRate) * config.bufferMs / 1000 * config.channels;
+    if (meterBlock.size() >= meterBlockSamples) {
+        processMeterBlock();
+        meterBlock.clear();
+    }
+    threshold = config.threshold;
+    if (spotter) {
+        spotter->setThreshold(static_cast<float>(config.kwsThreshold));
+        trimPreRoll();
+    }
+    if (powerSaving && config.powerSaveAfterMs > 0) {
+        backend->setWakeInterval(config.powerSaveWakeMs);
+    }
+    if (exporter) {
+        exporter->applyConfig(config);
     }
+    configApplied(changes);
+}
 
-    waveInHdr.lpData = (LPSTR)waveInBuffer;
-    waveInHdr.dwBufferLength = NUMPTS * sizeof(short);
-    waveInHdr.dwFlags = 0;
+void AudioRecorder::configApplied(const std::string& changes) {
+    if (changes.empty()) return;
 
-    waveInPrepareHeader(hWaveIn, &waveInHdr, sizeof(WAVEHDR));
-    waveInAddBuffer(hWaveIn, &waveInHdr, sizeof(WAVEHDR));
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t generation = metrics.configGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    metrics.configAppliedUnixMs.store(now, std::memory_order_relaxed);
+    std::cout << "Config #" << generation << " applied: " << changes << "\n";
+}
 
-    waveInStart(hWaveIn);
-    std::cout << "Recording started...\n";
+void AudioRecorder::setBackend(const std::string& name) {
+    RecorderConfig next = getConfig();
+    next.backend = name;
+    applyConfig(next);
+}
+
+void AudioRecorder::setSilenceTrim(int leadMs, int tailMs, int splitPauseMs) {
+    RecorderConfig next = getConfig();
+    next.trimLeadMs = leadMs;
+    next.trimTailMs = tailMs;
+    next.splitPauseMs = splitPauseMs;
+    applyConfig(next);
+}
 
-    while (!stopRecording) {
-        Sleep(100);
+void AudioRecorder::setThreshold(double percent) {
+    RecorderConfig next = getConfig();
+    next.threshold = std::clamp(percent, 0.0, 100.0);
+    applyConfig(next);
+}
+
+double AudioRecorder::getThreshold() const {
+    return threshold.load();
+}
+
+void AudioRecorder::setArmed(bool enabled) {
+    armed = enabled;
+    if (!enabled) {
+        isRecordStart = false;
+        stopRecordingNow();
     }
+}
 
-    waveInStop(hWaveIn);
-    waveInReset(hWaveIn);
-    waveInUnprepareHeader(hWaveIn, &waveInHdr, sizeof(WAVEHDR));
-    waveInClose(hWaveIn);
+bool AudioRecorder::isArmed() const {
+    return armed.load();
+}
 
-    std::string filename = "output_" + getCurrentDateTimeString() + ".wav";
-    saveToWav(filename, waveInBuffer, waveInHdr.dwBytesRecorded);
-    std::cout << "Recording saved to " << filename << "\n";
+bool AudioRecorder::isRecordingActive() const {
+    return isRecording.load();
+}
+
+bool AudioRecorder::isPowerSaving() const {
+    return powerSaving.load();
+}
+
+const RecorderMetrics& AudioRecorder::getMetrics() const {
+    return metrics;
+}
+
+uint64_t AudioRecorder::getOverruns() const {
+    return running && backend ? backend->getOverruns() : 0;
+}
+
+void AudioRecorder::setLevelListener(std::function<void(const LevelFrame&)> listener) {
+    std::lock_guard<std::mutex> lock(listenerMutex);
+    levelListener = std::move(listener);
+}
+
+#ifdef _WIN32
+void AudioRecorder::signalHandlerStatic(int) {
+    if (instance) {
+        std::cout << "\nCtrl+C received. Exiting...\n";
+        instance->requestStop();
+    }
+}
+#else
+// Only async-signal-safe calls here: locking runMutex could deadlock the
+// thread the signal interrupted
+void AudioRecorder::signalHandlerStatic(int signal) {
+    int savedErrno = errno;
+    unsigned char number = static_cast<unsigned char>(signal);
+    (void)!write(signalPipe[1], &number, 1);
+    errno = savedErrno;
+}
+
+void AudioRecorder::watchSignals() {
+    while (true) {
+        unsigned char number = 0;
+        ssize_t got = read(signalPipe[0], &number, 1);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0 || number == 0) return;
+
+        std::cout << "\nCtrl+C received. Exiting...\n";
+        requestStop();
+    }
+}
+#endif
+
+std::string AudioRecorder::getDateTimeString(int64_t unixNs) {
+    std::chrono::sys_time<std::chrono::milliseconds> time{std::chrono::milliseconds(unixNs / 1000000)};
+    return std::format("{:%Y-%m-%d_%H-%M-%S}", time);
+}
+
+void AudioRecorder::recordingThread(RecorderConfig settings) {
+    // Names and metadata come from the capture clock of each segment's first frame
+    std::string baseName;
+    BlockStamp streamStamp;
+    BlockStamp segmentStamp;
+    bool streamStarted = false;
+    WavWriter writer;
+    SilenceSplitter splitter(settings.sampleRate, settings.channels, settings.threshold,
+                             settings.trimLeadMs, settings.trimTailMs, settings.splitPauseMs);
+    bool dedup = settings.dedup != "off";
+    auto lastCheckpoint = std::chrono::steady_clock::now();
+    Fingerprinter fingerprinter(settings.sampleRate, settings.channels);
+    QualityMeter quality(settings.sampleRate, settings.channels);
+    uint64_t blockOverruns = 0;
+    uint64_t segmentOverruns = 0;
+    bool segmentOpen = false;
+
+    splitter.onSegmentStart = [&](int index) {
+        segmentStamp = streamStamp.advanced(splitter.getSegmentStart() / settings.channels);
+        if (baseName.empty()) {
+            baseName = settings.outputPrefix + getDateTimeString(segmentStamp.unixNs);
+        }
+        std::string filename = baseName + (index > 0 ? "_" + std::to_string(index) : "") + ".wav";
+        segmentOpen = writer.open(filename, settings.sampleRate, settings.channels, settings.bitsPerSample);
+        if (segmentOpen) {
+            journal.begin(filename);
+        }
+        lastCheckpoint = std::chrono::steady_clock::now();
+        fingerprinter.reset();
+        quality.reset();
+        segmentOverruns = blockOverruns;
+    };
+    splitter.onSegmentData = [&](const short* data, size_t samples) {
+        writer.write(data, samples);
+        if (dedup) fingerprinter.push(data, samples);
+        quality.push(data, samples);
+    };
+    splitter.onSegmentEnd = [&](int) {
+        // getFilename() still names the previous segment, which is saved already
+        if (!segmentOpen) return;
+        segmentOpen = false;
+
+        RecordingEntry entry;
+        entry.file = writer.getFilename();
+        entry.start = segmentStamp;
+        entry.frames = writer.getDataSize() / (settings.channels * settings.bitsPerSample / 8);
+        entry.nominalRate = settings.sampleRate;
+        entry.quality = quality.getQuality(blockOverruns - segmentOverruns);
+
+        std::chrono::sys_time<std::chrono::milliseconds> created{std::chrono::milliseconds(segmentStamp.unixNs / 1000000)};
+        writer.addInfo("ICRD", std::format("{:%Y-%m-%dT%H:%M:%SZ}", created));
+        writer.addChunk("time", RecordingIndex::describe(entry));
+        writer.addChunk("qlty", QualityMeter::describe(entry.quality));
+        writer.close();
+        journal.end(writer.getFilename());
+        if (dedup && dropDuplicate(writer.getFilename(), fingerprinter.getHashes(), settings)) {
+            return;
+        }
+        if (!settings.recordingIndex.empty() &&
+            (recordingIndex.getPath() == settings.recordingIndex || recordingIndex.open(settings.recordingIndex))) {
+            recordingIndex.append(entry);
+        }
+        if (exporter) {
+            exporter->add(entry);
+        }
+        metrics.recordingsSaved.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "Recording saved to " << writer.getFilename() << "\n";
+    };
+
+    std::cout << "Recording started...\n";
+
+    // Blocks are queued by the capture thread; file I/O only ever happens here
+    // Segments are cut from the recording, so capping it keeps every file under the WAV size limit
+    const uint64_t NUMPTS = std::min<uint64_t>(
+        static_cast<uint64_t>(settings.sampleRate) * settings.channels * settings.recordSeconds,
+        WavWriter::MAX_DATA_SIZE / (sizeof(short) * settings.channels) * settings.channels);
+    uint64_t recorded = 0;
+    bool done = false;
+    while (!done) {
+        // Sleeps until the capture thread queues a block or asks to stop
+        std::deque<RecordBlock> blocks;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(recordMutex);
+            recordCV.wait(lock, [this] { return !recordQueue.empty() || stopRecording; });
+            stopping = stopRecording;
+            blocks.swap(recordQueue);
+        }
+        for (auto& block : blocks) {
+            if (!streamStarted) {
+                streamStamp = block.stamp;
+                streamStarted = true;
+            }
+            blockOverruns = block.overruns;
+            size_t samples = static_cast<size_t>(std::min<uint64_t>(block.samples.size(), NUMPTS - recorded));
+            splitter.push(block.samples.data(), samples);
+            recorded += samples;
+
+            auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - block.captured).count();
+            metrics.writeLatencyMsLast.store(static_cast<uint32_t>(latency), std::memory_order_relaxed);
+            RecorderMetrics::updateMax(metrics.writeLatencyMsMax, static_cast<uint32_t>(latency));
+        }
+
+        // Bound what a crash can cost: the header and data on disk trail by at most checkpoint_ms
+        auto now = std::chrono::steady_clock::now();
+        if (writer.isOpen() && !blocks.empty() &&
+            (settings.fsync == "always" || now - lastCheckpoint >= std::chrono::milliseconds(settings.checkpointMs))) {
+            writer.checkpoint(settings.fsync != "none");
+            lastCheckpoint = now;
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - now).count();
+            metrics.checkpointUsLast.store(static_cast<uint32_t>(elapsed), std::memory_order_relaxed);
+            RecorderMetrics::updateMax(metrics.checkpointUsMax, static_cast<uint32_t>(elapsed));
+        }
+
+        done = stopping || recorded >= NUMPTS;
+    }
+
+    splitter.finish();
 
-    delete[] waveInBuffer;
-    waveInBuffer = nullptr;
-    isRecording = false;
     stopRecording = false;
+    isRecording = false;
+}
+
+bool AudioRecorder::dropDuplicate(const std::string& filename, const std::vector<FingerprintHash>& hashes,
+                                  const RecorderConfig& settings) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (fingerprints.getPath() != settings.dedupIndex &&
+        !fingerprints.open(settings.dedupIndex, now - settings.dedupWindowSeconds * 1000LL)) {
+        return false;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    FingerprintIndex::Match match;
+    bool duplicate = fingerprints.findMatch(hashes, now - settings.dedupWindowSeconds * 1000LL, match);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    metrics.dedupLookupUsLast.store(static_cast<uint32_t>(elapsed), std::memory_order_relaxed);
+    RecorderMetrics::updateMax(metrics.dedupLookupUsMax, static_cast<uint32_t>(elapsed));
+
+    if (!duplicate) {
+        // Only originals are indexed, so the window runs from the first time a sound was heard
+        fingerprints.add(filename, now, hashes);
+        return false;
+    }
+
+    metrics.duplicatesFound.fetch_add(1, std::memory_order_relaxed);
+    if (settings.dedup == "drop") {
+        std::remove(filename.c_str());
+        std::cout << "Dropped " << filename << ", duplicate of " << match.name
+                  << " (" << match.votes << "/" << match.queried << " hashes)\n";
+        return true;
+    }
+    std::cout << "Recording " << filename << " duplicates " << match.name
+              << " (" << match.votes << "/" << match.queried << " hashes)\n";
+    return false;
 }
 
 void AudioRecorder::startRecording() {
     if (!isRecording) {
+        if (recordThread.joinable()) {
+            recordThread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(recordMutex);
+            recordQueue.clear();
+        }
         isRecording = true;
         stopRecording = false;
-        std::thread(&AudioRecorder::recordingThread, this).detach();
+        recordThread = std::thread(&AudioRecorder::recordingThread, this, config);
     }
 }
 
 void AudioRecorder::stopRecordingNow() {
     if (isRecording) {
-        stopRecording = true;
+        {
+            std::lock_guard<std::mutex> lock(recordMutex);
+            stopRecording = true;
+        }
+        recordCV.notify_one();
     }
 }
 
-void CALLBACK AudioRecorder::waveInProc(HWAVEIN hWaveIn, UINT uMsg, DWORD_PTR dwInstance, DWORD_PTR dwParam1, DWORD_PTR dwParam2) {
-    if (uMsg != WIM_DATA) return;
+void AudioRecorder::processBlock(const short* samples, size_t count) {
+    auto started = std::chrono::steady_clock::now();
+    if (configPending) {
+        applyPendingConfig();
+    }
 
-    auto* ctx = reinterpret_cast<AudioContext*>(dwInstance);
-    auto* hdr = reinterpret_cast<WAVEHDR*>(dwParam1);
+    BlockStamp stamp = captureClock.onPacket(count / config.channels);
+    metrics.packets.fetch_add(1, std::memory_order_relaxed);
+    metrics.framesCaptured.fetch_add(count / config.channels, std::memory_order_relaxed);
+    metrics.deviceRateMilliHz.store(static_cast<uint64_t>(captureClock.getRate() * 1000.0), std::memory_order_relaxed);
+    metrics.clockDriftPpb.store(static_cast<int64_t>(captureClock.getDriftPpm() * 1000.0), std::memory_order_relaxed);
+    metrics.clockJitterUs.store(static_cast<uint32_t>(captureClock.getJitterUs()), std::memory_order_relaxed);
+
+    bool wake = false;
+    {
+        // Held while the listener runs, so setLevelListener() never returns during a call
+        std::lock_guard<std::mutex> lock(listenerMutex);
+        int peak = 0;
+        if (levelListener || powerSaving) {
+            peak = peakOf(samples, count, config.channels, powerSaving ? config.powerSaveDecimation : 1);
+        }
+        wake = powerSaving && peak / 32767.0 * 100.0 > threshold * WAKE_FRACTION;
+
+        if (levelListener) {
+            LevelFrame frame{};
+            frame.sequence = levelSequence++;
+            frame.level = static_cast<float>(std::min(100.0, (peak / 32767.0) * 100.0));
+            frame.frames = static_cast<uint32_t>(count / config.channels);
+            frame.flags = (isRecording ? LEVEL_FLAG_RECORDING : 0) | (armed ? LEVEL_FLAG_ARMED : 0);
+            levelListener(frame);
+        }
+    }
+    // Outside the lock: the spotter's pre-roll replay is a whole inference pass
+    if (wake) {
+        leavePowerSave();
+    }
 
-    const int16_t* samples = reinterpret_cast<const int16_t*>(hdr->lpData);
-    size_t sampleCount = hdr->dwBytesRecorded / sizeof(int16_t);
-    int peak = 0;
-    for (size_t i = 0; i < sampleCount; ++i) {
-        peak = std::max(peak, std::abs((int)samples[i]));
+    if (spotter && !powerSaving) {
+        int keyword = spotter->push(samples, count);
+        if (keyword >= 0) {
+            keywordHeard = true;
+            metrics.keywordDetections.fetch_add(1, std::memory_order_relaxed);
+            std::cout << "Keyword: " << spotter->getLabels()[keyword] << "\n";
+        }
     }
+
+    size_t consumed = 0;
+    while (count > 0) {
+        if (meterBlock.empty()) {
+            meterStamp = stamp.advanced(consumed / config.channels);
+        }
+        size_t n = std::min(count, meterBlockSamples - meterBlock.size());
+        meterBlock.insert(meterBlock.end(), samples, samples + n);
+        samples += n;
+        count -= n;
+        consumed += n;
+
+        if (meterBlock.size() == meterBlockSamples) {
+            processMeterBlock();
+            meterBlock.clear();
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    metrics.processUsLast.store(static_cast<uint32_t>(elapsed), std::memory_order_relaxed);
+    RecorderMetrics::updateMax(metrics.processUsMax, static_cast<uint32_t>(elapsed));
+}
+
+void AudioRecorder::processMeterBlock() {
+    int peak = peakOf(meterBlock.data(), meterBlock.size(), config.channels,
+                      powerSaving ? config.powerSaveDecimation : 1);
     double level = std::min(100.0, (peak / 32767.0) * 100.0);
 
-    std::cout << "Speech level: " << level << "%\n";
+    if (logLevels) {
+        std::cout << "Speech level: " << level << "%\n";
+    }
+    metrics.meterBlocks.fetch_add(1, std::memory_order_relaxed);
+
+    latestLevel.store(level);
+    {
+        std::lock_guard<std::mutex> lock(levelMutex);
+        levelQueue.push(level);
+        while (levelQueue.size() > static_cast<size_t>(config.levelQueueSize)) {
+            levelQueue.pop();
+            metrics.levelQueueDrops.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    levelCV.notify_one();
+
+    double limit = threshold;
+    bool trigger = spotter ? keywordHeard : level > limit;
+    keywordHeard = false;
+    if (armed && !isRecordStart && trigger) {
+        isRecordStart = true;
+        quietMs = 0;
+        startRecording();
+
+        // The keyword itself was spoken before it was recognised
+        std::lock_guard<std::mutex> lock(recordMutex);
+        for (auto& block : preRoll) {
+            recordQueue.push_back(std::move(block));
+        }
+        preRoll.clear();
+    }
 
-    if (instance->isRecordStart) {
-        if (level <= 10.0) {
-            instance->isRecordStart = false;
-            instance->stopRecordingNow();
+    // The block that crossed the threshold is part of the recording, so the onset is kept
+    if (isRecordStart && isRecording && !stopRecording) {
+        {
+            std::lock_guard<std::mutex> lock(recordMutex);
+            recordQueue.push_back({meterBlock, std::chrono::steady_clock::now(), meterStamp, backend->getOverruns()});
         }
-    } else {
-        if (level > 10.0) {
-            instance->isRecordStart = true;
-            instance->startRecording();
+        recordCV.notify_one();
+    } else if (spotter) {
+        preRoll.push_back({meterBlock, std::chrono::steady_clock::now(), meterStamp, backend->getOverruns()});
+        trimPreRoll();
+    }
+
+    // Shorter pauses stay in the recording for the splitter to cut; record_seconds still caps it
+    quietMs = level <= limit ? quietMs + config.bufferMs : 0;
+    if (isRecordStart && level <= limit && quietMs > config.endPauseMs) {
+        isRecordStart = false;
+        stopRecordingNow();
+    }
+
+    // Long quiet with nothing being recorded switches to cheap metering
+    if (powerSaving) {
+        metrics.powerSaveMs.fetch_add(config.bufferMs, std::memory_order_relaxed);
+    }
+    silentMs = level <= limit && !isRecordStart && !isRecording ? silentMs + config.bufferMs : 0;
+    if (config.powerSaveAfterMs == 0) {
+        if (powerSaving) leavePowerSave();
+    } else if (!powerSaving && silentMs >= config.powerSaveAfterMs) {
+        enterPowerSave();
+    }
+}
+
+void AudioRecorder::trimPreRoll() {
+    // By duration, not block count: after a hot buffer_ms change old and new block sizes mix
+    size_t needed = static_cast<size_t>(config.sampleRate) * spotter->getContextMs() / 1000 * config.channels;
+    size_t held = 0;
+    for (const RecordBlock& block : preRoll) {
+        held += block.samples.size();
+    }
+    while (!preRoll.empty() && held - preRoll.front().samples.size() > needed) {
+        held -= preRoll.front().samples.size();
+        preRoll.pop_front();
+    }
+}
+
+void AudioRecorder::enterPowerSave() {
+    powerSaving = true;
+    metrics.powerSaveEntries.fetch_add(1, std::memory_order_relaxed);
+    bool slower = backend->setWakeInterval(config.powerSaveWakeMs);
+    std::cout << "Power saving after " << silentMs / 1000 << " s of quiet"
+              << (slower ? "" : " (backend keeps its wake interval)") << "\n";
+}
+
+void AudioRecorder::leavePowerSave() {
+    powerSaving = false;
+    silentMs = 0;
+    backend->setWakeInterval(0);
+
+    // The spotter missed what was said while it paused; the pre-roll holds
+    // the last context window of audio, so it catches up before going on
+    if (spotter) {
+        spotter->reset();
+        for (const RecordBlock& block : preRoll) {
+            if (spotter->push(block.samples.data(), block.samples.size()) >= 0) keywordHeard = true;
         }
+        if (spotter->push(meterBlock.data(), meterBlock.size()) >= 0) keywordHeard = true;
+        if (keywordHeard) metrics.keywordDetections.fetch_add(1, std::memory_order_relaxed);
     }
+}
 
-    waveInAddBuffer(ctx->hWaveIn, hdr, sizeof(WAVEHDR));
+double AudioRecorder::getLatestLevel() {
+    return latestLevel.load();
+}
+
+bool AudioRecorder::hasNewLevel() {
+    std::lock_guard<std::mutex> lock(levelMutex);
+    return !levelQueue.empty();
+}
+
+void AudioRecorder::clearLevels() {
+    std::lock_guard<std::mutex> lock(levelMutex);
+    while (!levelQueue.empty()) {
+        levelQueue.pop();
+    }
+}
+
+template<typename T>
+bool AudioRecorder::getNextLevel(T& level, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(levelMutex);
+
+    if (levelCV.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+        [this]() { return !levelQueue.empty() || !running; })) {
+
+        if (!levelQueue.empty()) {
+            level = levelQueue.front();
+            levelQueue.pop();
+            return true;
+        }
+    }
+    return false;
 }
 
 void AudioRecorder::monitorMicLevel() {
-    AudioContext ctx;
-    ctx.wfx.wFormatTag = WAVE_FORMAT_PCM;
-    ctx.wfx.nChannels = 1;
-    ctx.wfx.nSamplesPerSec = 44100;
-    ctx.wfx.wBitsPerSample = 16;
-    ctx.wfx.nBlockAlign = (ctx.wfx.nChannels * ctx.wfx.wBitsPerSample) / 8;
-    ctx.wfx.nAvgBytesPerSec = ctx.wfx.nSamplesPerSec * ctx.wfx.nBlockAlign;
-
-    if (waveInOpen(&ctx.hWaveIn, WAVE_MAPPER, &ctx.wfx, (DWORD_PTR)waveInProc, (DWORD_PTR)&ctx, CALLBACK_FUNCTION) != MMSYSERR_NOERROR) {
-        std::cerr << "Failed to open recording device\n";
-        return;
+    // Capture settings changed while stopped (or deferred while running) apply here
+    std::string changes;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        changes = config.diff(pendingConfig);
+        config = pendingConfig;
+        configPending = false;
     }
+    meterBlockSamples = static_cast<size_t>(config.sampleRate) * config.bufferMs / 1000 * config.channels;
+    threshold = config.threshold;
+    configApplied(changes);
 
-    const DWORD bufferMs = 250;
-    const DWORD bufferBytes = (ctx.wfx.nAvgBytesPerSec * bufferMs) / 1000;
-    const int bufferCount = 2;
+    // Sessions a crashed run left open are repaired before anything new is written
+    if (config.journal.empty()) {
+        journal.close();
+    } else {
+        int repaired = journal.open(config.journal, config.fsync != "none");
+        if (repaired > 0) {
+            metrics.recordingsRecovered.fetch_add(repaired, std::memory_order_relaxed);
+        }
+    }
 
-    ctx.buffers.resize(bufferCount);
-    ctx.headers.resize(bufferCount);
+    spotter.reset();
+    preRoll.clear();
+    keywordHeard = false;
+    if (config.trigger == "keyword") {
+        spotter = std::make_unique<KeywordSpotter>(config.sampleRate, config.channels);
+        std::vector<std::string> keywords;
+        std::istringstream list(config.kwsKeywords);
+        for (std::string name; std::getline(list, name, ',');) {
+            if (!name.empty()) keywords.push_back(name);
+        }
 
-    for (int i = 0; i < bufferCount; ++i) {
-        ctx.buffers[i].resize(bufferBytes);
-        ZeroMemory(&ctx.headers[i], sizeof(WAVEHDR));
-        ctx.headers[i].lpData = reinterpret_cast<LPSTR>(ctx.buffers[i].data());
-        ctx.headers[i].dwBufferLength = bufferBytes;
+        std::string error;
+        if (!spotter->load(config.kwsModel, error) || !spotter->setKeywords(keywords, error)) {
+            std::cerr << "Keyword trigger unavailable: " << error << "\n";
+            spotter.reset();
+            requestStop();
+            return;
+        }
+        spotter->setThreshold(static_cast<float>(config.kwsThreshold));
+        std::cout << "Keyword trigger: " << spotter->getMemoryBytes() / 1024 << " KiB model state\n";
+    }
 
-        waveInPrepareHeader(ctx.hWaveIn, &ctx.headers[i], sizeof(WAVEHDR));
-        waveInAddBuffer(ctx.hWaveIn, &ctx.headers[i], sizeof(WAVEHDR));
+    if (!backend || config.backend != backendSpec) {
+        backend = createCaptureBackend(config.backend);
+        backendSpec = config.backend;
+    }
+    if (!backend) {
+        std::cerr << "Unknown capture backend: " << config.backend << "\n";
+        requestStop();
+        return;
     }
 
-    waveInStart(ctx.hWaveIn);
+    captureClock.start(config.sampleRate);
+    meterBlock.clear();
+    powerSaving = false;
+    silentMs = 0;
+
+    CaptureFormat format{config.sampleRate, config.channels, config.bitsPerSample};
+    backend->setErrorCallback([this](const std::string& message) {
+        std::cerr << "Capture stopped: " << message << "\n";
+        requestStop();
+    });
+    if (!backend->open(format, config.periodMs, [this](const short* samples, size_t count) {
+            processBlock(samples, count);
+        })) {
+        std::cerr << "Failed to open recording device\n";
+        requestStop();
+        return;
+    }
+
+    // Export trouble never stops capture, recordings simply stay local
+    if (!config.exportTo.empty()) {
+        exporter = std::make_unique<Exporter>(metrics);
+        if (!exporter->start(config)) {
+            exporter.reset();
+        }
+    }
 
-    while (running) {
-        Sleep(50);
+    if (!backend->start()) {
+        backend->close();
+        exporter.reset();
+        requestStop();
+        return;
     }
 
-    waveInStop(ctx.hWaveIn);
-    waveInReset(ctx.hWaveIn);
+    std::cout << "Audio monitoring started (" << backend->name() << ")\n";
+
+    // Nothing to do here until stop, apart from refreshing the usage figures
+    uint64_t cpuUs = 0;
+    uint64_t wakeups = 0;
+    bool countsWakeups = readProcessUsage(cpuUs, wakeups);
+    if (!countsWakeups) wakeups = metrics.packets.load();
+    auto sampled = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(runMutex);
+        while (running) {
+            runCV.wait_for(lock, USAGE_INTERVAL);
+
+            // Without an OS count, capture wakeups stand in for all of them
+            uint64_t nowCpuUs = 0;
+            uint64_t nowWakeups = 0;
+            readProcessUsage(nowCpuUs, nowWakeups);
+            if (!countsWakeups) nowWakeups = metrics.packets.load();
+            auto now = std::chrono::steady_clock::now();
+            double hours = std::chrono::duration<double, std::ratio<3600>>(now - sampled).count();
+            if (hours > 0.0) {
+                metrics.cpuMsPerHour.store(static_cast<uint64_t>((nowCpuUs - cpuUs) / 1000.0 / hours), std::memory_order_relaxed);
+                metrics.wakeupsPerHour.store(static_cast<uint64_t>((nowWakeups - wakeups) / hours), std::memory_order_relaxed);
+            }
+            cpuUs = nowCpuUs;
+            wakeups = nowWakeups;
+            sampled = now;
+        }
+    }
 
-    for (int i = 0; i < bufferCount; ++i) {
-        waveInUnprepareHeader(ctx.hWaveIn, &ctx.headers[i], sizeof(WAVEHDR));
+    backend->stop();
+    backend->close();
+    meterBlock.clear();
+
+    // Let an active recording flush its last blocks before returning
+    isRecordStart = false;
+    stopRecordingNow();
+    if (recordThread.joinable()) {
+        recordThread.join();
     }
+    exporter.reset();
+    std::cout << "Audio monitoring stopped\n";
+}
 
-    waveInClose(ctx.hWaveIn);
-}
\ No newline at end of file
+// Explicit instantiation of the template
+template bool AudioRecorder::getNextLevel<double>(double& level, int timeoutMs);
@@ -8,55 +8,172 @@
 #ifndef AUDIORECORDER_H
 #define AUDIORECORDER_H
 
-#include <windows.h>
-#include <mmsystem.h>
+#include "CaptureBackend.h"
+#include "CaptureClock.h"
+#include "Exporter.h"
+#include "FingerprintIndex.h"
+#include "KeywordSpotter.h"
+#include "RecorderConfig.h"
+#include "RecorderMetrics.h"
+#include "RecordingIndex.h"
+#include "RecordingJournal.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
 #include <vector>
-#include <csignal>
-
-#pragma comment(lib,"winmm.lib")
 
 class AudioRecorder {
 public:
     AudioRecorder(int sampleRate = 44100, int channels = 2, int bitsPerSample = 16, int recordSeconds = 5);
+    explicit AudioRecorder(const RecorderConfig& config);
+    ~AudioRecorder();
+
+    // Console mode: blocks until Ctrl+C
     void run();
+    void handleSignals();
+
+    // Background mode for the GUI
+    void start();
+    void stop();
+    bool isRunning() const;
+    // stop() without the join, safe from any thread; waitUntilStopped() returns
+    // after it, stop(), a signal or a failed capture start
+    void requestStop();
+    void waitUntilStopped();
+
+    void setBackend(std::unique_ptr<CaptureBackend> customBackend);
+    void setLevelLogging(bool enabled);
+
+    // Safe to call while capturing. Hot settings take effect at the next block
+    // boundary, capture settings on the next start().
+    void applyConfig(const RecorderConfig& config);
+    RecorderConfig getConfig() const;
+    void setBackend(const std::string& name);
+    void setSilenceTrim(int leadMs, int tailMs, int splitPauseMs);
+    void setThreshold(double percent);
+    double getThreshold() const;
+    void setArmed(bool enabled);
+    bool isArmed() const;
+    bool isRecordingActive() const;
+    bool isPowerSaving() const;
+
+    const RecorderMetrics& getMetrics() const;
+    uint64_t getOverruns() const;
+
+    // Called on the capture thread for every packet. May be replaced or cleared
+    // (nullptr) while running; once this returns the old listener is not called again
+    void setLevelListener(std::function<void(const LevelFrame&)> listener);
+
+    double getLatestLevel();
+    bool hasNewLevel();
+    void clearLevels();
+
+    template<typename T>
+    bool getNextLevel(T& level, int timeoutMs = 100);
 
 private:
-    int sampleRate;
-    int channels;
-    int bitsPerSample;
-    int recordSeconds;
-    int NUMPTS;
+    // Owned by the capture thread while running; pendingConfig is the latest requested one
+    RecorderConfig config;
+    RecorderConfig pendingConfig;
+    std::atomic<bool> configPending;
+    mutable std::mutex configMutex;
+
+    std::unique_ptr<CaptureBackend> backend;
+    std::string backendSpec; // config.backend value the current backend was created from
 
-    short* waveInBuffer;
     std::atomic<bool> isRecording;
     std::atomic<bool> stopRecording;
     std::atomic<bool> isRecordStart;
     std::atomic<bool> running;
+    std::mutex runMutex;
+    std::condition_variable runCV;  // the monitor thread waits here for stop
+    std::atomic<bool> armed;
+    std::atomic<double> threshold;
+    bool logLevels;
 
-    struct AudioContext {
-        HWAVEIN hWaveIn;
-        WAVEFORMATEX wfx;
-        std::vector<WAVEHDR> headers;
-        std::vector<std::vector<BYTE>> buffers;
+    RecorderMetrics metrics;
+    std::function<void(const LevelFrame&)> levelListener;
+    std::mutex listenerMutex;
+    uint32_t levelSequence;
 
-        AudioContext();
+    struct RecordBlock {
+        std::vector<short> samples;
+        std::chrono::steady_clock::time_point captured;
+        BlockStamp stamp;
+        uint64_t overruns;  // backend overrun count when the block was completed
     };
 
+    // Keyword trigger, capture thread only; preRoll keeps the blocks the keyword
+    // was spoken in, enough of them to cover the spotter's context
+    std::unique_ptr<KeywordSpotter> spotter;
+    bool keywordHeard;
+    std::deque<RecordBlock> preRoll;
+    int quietMs;
+
+    // Metering works on fixed blocks regardless of the backend period
+    std::vector<short> meterBlock;
+    size_t meterBlockSamples;
+    CaptureClock captureClock;
+    BlockStamp meterStamp;
+
+    // Capture thread only, except the flag which status readers see
+    std::atomic<bool> powerSaving;
+    int silentMs;
+
+    std::atomic<double> latestLevel;
+    std::queue<double> levelQueue;
+    std::mutex levelMutex;
+    std::condition_variable levelCV;
+
+    std::deque<RecordBlock> recordQueue;
+    std::mutex recordMutex;
+    std::condition_variable recordCV;  // a block was queued or stopRecording was set
+
+    std::thread workerThread;
+    std::thread recordThread;
+
+    // Only touched by the recording thread, of which there is at most one
+    FingerprintIndex fingerprints;
+    RecordingJournal journal;
+    RecordingIndex recordingIndex;
+
+    // Runs from capture start to stop when export is configured; the recording thread feeds it
+    std::unique_ptr<Exporter> exporter;
+
     static AudioRecorder* instance;
+#ifndef _WIN32
+    // The handler only writes the signal number here; signalThread reads it
+    // and stops the recorder, whether or not capture is still delivering
+    static int signalPipe[2];
+    std::thread signalThread;
+    void watchSignals();
+#endif
 
     static void signalHandlerStatic(int signal);
-    void signalHandler(int signal);
-    static std::string getCurrentDateTimeString();
-    void saveToWav(const std::string& filename, short* data, int dataSize);
-    void recordingThread();
+    static std::string getDateTimeString(int64_t unixNs);
+    void applyPendingConfig();
+    void configApplied(const std::string& changes);
+    void recordingThread(RecorderConfig settings);
+    bool dropDuplicate(const std::string& filename, const std::vector<FingerprintHash>& hashes,
+                       const RecorderConfig& settings);
     void startRecording();
     void stopRecordingNow();
-    static void CALLBACK waveInProc(HWAVEIN hWaveIn, UINT uMsg, DWORD_PTR dwInstance, DWORD_PTR dwParam1, DWORD_PTR dwParam2);
+    void processBlock(const short* samples, size_t count);
+    void processMeterBlock();
+    void trimPreRoll();
+    void enterPowerSave();
+    void leavePowerSave();
     void monitorMicLevel();
 };
 
 #endif // AUDIORECORDER_H
 
-#endif //COURSE_AUDIORECORDER_H
\ No newline at end of file
+#endif //COURSE_AUDIORECORDER_H
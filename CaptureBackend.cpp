@@ -0,0 +1,54 @@
+#include "CaptureBackend.h"
+#include "MixerCapture.h"
+#include "MockCapture.h"
+
+#ifdef _WIN32
+#include "WinMMCapture.h"
+#include "WasapiCapture.h"
+#endif
+
+#ifdef COURSE_HAVE_ALSA
+#include "AlsaCapture.h"
+#endif
+
+static std::vector<std::string> splitInputs(const std::string& list) {
+    std::vector<std::string> names;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find('+', begin);
+        if (end == std::string::npos) end = list.size();
+        if (end > begin) names.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return names;
+}
+
+std::unique_ptr<CaptureBackend> createCaptureBackend(const std::string& name) {
+    if (name.rfind("mix:", 0) == 0) {
+        return std::make_unique<MixerCapture>(splitInputs(name.substr(4)), StreamMixer::Output::Interleaved);
+    }
+    if (name.rfind("mixdown:", 0) == 0) {
+        return std::make_unique<MixerCapture>(splitInputs(name.substr(8)), StreamMixer::Output::Downmix);
+    }
+#ifdef _WIN32
+    if (name == "winmm") return std::make_unique<WinMMCapture>();
+    if (name == "wasapi") return std::make_unique<WasapiCapture>(false);
+    if (name == "wasapi-exclusive") return std::make_unique<WasapiCapture>(true);
+#endif
+#ifdef COURSE_HAVE_ALSA
+    if (name == "alsa") return std::make_unique<AlsaCapture>();
+    if (name.rfind("alsa:", 0) == 0) return std::make_unique<AlsaCapture>(name.substr(5));
+#endif
+    if (name == "mock") return std::make_unique<MockCapture>();
+    return nullptr;
+}
+
+const char* defaultCaptureBackend() {
+#if defined(_WIN32)
+    return "winmm";
+#elif defined(COURSE_HAVE_ALSA)
+    return "alsa";
+#else
+    return "mock";
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef COURSE_CAPTUREBACKEND_H
+#define COURSE_CAPTUREBACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+struct CaptureFormat {
+    int sampleRate;
+    int channels;
+    int bitsPerSample;
+};
+
+// Common interface of the capture APIs. A backend delivers interleaved 16-bit
+// PCM to the callback from its own capture thread, roughly once per period.
+class CaptureBackend {
+public:
+    using BlockCallback = std::function<void(const short* samples, size_t count)>;
+    using ErrorCallback = std::function<void(const std::string& message)>;
+
+    virtual ~CaptureBackend() = default;
+
+    virtual bool open(const CaptureFormat& format, int periodMs, BlockCallback callback) = 0;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual void close() = 0;
+    virtual const char* name() const = 0;
+
+    // Data lost by the device or driver since open()
+    virtual uint64_t getOverruns() const { return 0; }
+
+    // Asks the capture thread to wake only every ms milliseconds (0 restores
+    // the period) and hand over what the device buffered meanwhile. Safe to
+    // call from the callback; returns false if the backend cannot do it.
+    virtual bool setWakeInterval(int /*ms*/) { return false; }
+
+    // Called from the capture thread when capture ends without stop(), e.g.
+    // on an unrecoverable device error. Set before start().
+    void setErrorCallback(ErrorCallback callback) { errorCallback = std::move(callback); }
+
+protected:
+    void reportError(const std::string& message) {
+        if (errorCallback) errorCallback(message);
+    }
+
+private:
+    ErrorCallback errorCallback;
+};
+
+// "winmm", "wasapi", "wasapi-exclusive" (Windows), "alsa" or "alsa:<pcm name>" (Linux)
+// or "mock"; "mix:a+b+..." records several of them as one multichannel stream and
+// "mixdown:a+b+..." as a mono downmix. Returns nullptr for unknown names.
+std::unique_ptr<CaptureBackend> createCaptureBackend(const std::string& name);
+const char* defaultCaptureBackend();
+
+#endif //COURSE_CAPTUREBACKEND_H
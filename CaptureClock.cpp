@@ -0,0 +1,85 @@
+#include "CaptureClock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double WEIGHT = 1.0 / 2000.0;   // per packet
+    const uint64_t SETTLE_PACKETS = 50;   // devices deliver the first packets in bursts while buffers fill
+    const uint64_t WARMUP_PACKETS = 150;  // keep the nominal rate until the fit has some history
+}
+
+BlockStamp BlockStamp::advanced(uint64_t count) const {
+    BlockStamp next = *this;
+    next.frame += count;
+    if (rate > 0.0) {
+        int64_t ns = static_cast<int64_t>(count * 1e9 / rate);
+        next.monotonicNs += ns;
+        next.unixNs += ns;
+    }
+    return next;
+}
+
+void CaptureClock::start(int rate) {
+    nominalRate = rate;
+    frames = 0;
+    packets = 0;
+    steadyStart = std::chrono::steady_clock::now();
+    unixStartNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    lastStampNs = 0;
+    meanFrame = meanTime = varFrame = covFrameTime = jitterVariance = 0.0;
+    secondsPerFrame = 1.0 / std::max(rate, 1);
+}
+
+BlockStamp CaptureClock::onPacket(size_t count) {
+    auto now = std::chrono::steady_clock::now();
+    double arrival = std::chrono::duration<double>(now - steadyStart).count();
+
+    // The packet's last frame has just been captured
+    double x = static_cast<double>(frames + count);
+    if (packets <= SETTLE_PACKETS) {
+        // Anchor the line on the latest packet only
+        meanFrame = x;
+        meanTime = arrival;
+    } else {
+        double predicted = meanTime + (x - meanFrame) * secondsPerFrame;
+        double residual = arrival - predicted;
+        jitterVariance += WEIGHT * (residual * residual - jitterVariance);
+
+        double dx = x - meanFrame;
+        double dt = arrival - meanTime;
+        meanFrame += WEIGHT * dx;
+        meanTime += WEIGHT * dt;
+        varFrame = (1.0 - WEIGHT) * (varFrame + WEIGHT * dx * dx);
+        covFrameTime = (1.0 - WEIGHT) * (covFrameTime + WEIGHT * dx * dt);
+        if (packets >= WARMUP_PACKETS && varFrame > 0.0) {
+            secondsPerFrame = covFrameTime / varFrame;
+        }
+    }
+    ++packets;
+
+    BlockStamp stamp;
+    stamp.frame = frames;
+    stamp.rate = 1.0 / secondsPerFrame;
+    double fitted = meanTime + (static_cast<double>(frames) - meanFrame) * secondsPerFrame;
+    // A new fit must never move time backwards
+    stamp.monotonicNs = std::max(static_cast<int64_t>(fitted * 1e9), lastStampNs + 1);
+    lastStampNs = stamp.monotonicNs;
+    stamp.unixNs = unixStartNs + stamp.monotonicNs;
+    stamp.monotonicNs += std::chrono::duration_cast<std::chrono::nanoseconds>(steadyStart.time_since_epoch()).count();
+
+    frames += count;
+    return stamp;
+}
+
+double CaptureClock::getRate() const {
+    return 1.0 / secondsPerFrame;
+}
+
+double CaptureClock::getDriftPpm() const {
+    return nominalRate > 0 ? (getRate() / nominalRate - 1.0) * 1e6 : 0.0;
+}
+
+double CaptureClock::getJitterUs() const {
+    return std::sqrt(jitterVariance) * 1e6;
+}
@@ -0,0 +1,53 @@
+#ifndef COURSE_CAPTURECLOCK_H
+#define COURSE_CAPTURECLOCK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Where a block sits on the device's sample clock and on the host clocks.
+// Times are estimates for the block's first frame.
+struct BlockStamp {
+    uint64_t frame = 0;         // frames since capture started
+    int64_t monotonicNs = 0;    // steady_clock
+    int64_t unixNs = 0;         // system_clock, fixed to steady_clock when capture started
+    double rate = 0.0;          // estimated device frames per second
+
+    BlockStamp advanced(uint64_t frames) const;
+};
+
+// Counts captured frames and relates them to steady_clock. Packet arrival
+// times are fitted against the frame counter with an exponentially weighted
+// least squares line (time constant about 20 s at 10 ms packets); its slope
+// is the device's real sample rate and the residual is the delivery jitter.
+// Stamps come from the fitted line, so scheduling noise does not reach
+// them. Arrival includes the device buffer latency, which shifts every
+// stamp by the same amount. Capture thread only.
+class CaptureClock {
+public:
+    void start(int nominalRate);
+    // Call on arrival of every packet; returns the stamp of its first frame
+    BlockStamp onPacket(size_t frames);
+
+    double getRate() const;
+    double getDriftPpm() const;
+    double getJitterUs() const;
+
+private:
+    int nominalRate = 0;
+    uint64_t frames = 0;
+    uint64_t packets = 0;
+    std::chrono::steady_clock::time_point steadyStart;
+    int64_t unixStartNs = 0;
+    int64_t lastStampNs = 0;
+
+    // Weighted means and co-moments of (frame, arrival seconds)
+    double meanFrame = 0.0;
+    double meanTime = 0.0;
+    double varFrame = 0.0;
+    double covFrameTime = 0.0;
+    double secondsPerFrame = 0.0;
+    double jitterVariance = 0.0;
+};
+
+#endif //COURSE_CAPTURECLOCK_H
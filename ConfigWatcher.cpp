@@ -0,0 +1,59 @@
+#include "ConfigWatcher.h"
+#include <iostream>
+
+ConfigWatcher::ConfigWatcher(std::string path, RecorderConfig base,
+                             std::function<void(const RecorderConfig&)> onChange)
+    : path(std::move(path)), base(std::move(base)), onChange(std::move(onChange)), stopping(false) {
+    std::error_code ec;
+    lastWrite = std::filesystem::last_write_time(this->path, ec);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+void ConfigWatcher::start(int pollMs) {
+    if (thread.joinable()) return;
+    stopping = false;
+    thread = std::thread(&ConfigWatcher::watchThread, this, pollMs);
+}
+
+void ConfigWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+std::string ConfigWatcher::reloadNow() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::error_code ec;
+    lastWrite = std::filesystem::last_write_time(path, ec);
+
+    // Start from the base so keys removed from the file fall back instead of sticking
+    RecorderConfig loaded = base;
+    std::string error;
+    if (!RecorderConfig::load(path, loaded, error)) {
+        std::cerr << "Config not applied: " << error << "\n";
+        return error;
+    }
+    onChange(loaded);
+    return "";
+}
+
+void ConfigWatcher::watchThread(int pollMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(pollMs), [this] { return stopping; })) {
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(path, ec);
+        if (ec || modified == lastWrite) continue;
+
+        lock.unlock();
+        reloadNow();
+        lock.lock();
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef COURSE_CONFIGWATCHER_H
+#define COURSE_CONFIGWATCHER_H
+
+#include "RecorderConfig.h"
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reloads a config file when its modification time changes. Every load starts
+// from the base config; a file that fails to parse is reported and ignored,
+// so the last good config stays active.
+class ConfigWatcher {
+public:
+    ConfigWatcher(std::string path, RecorderConfig base, std::function<void(const RecorderConfig&)> onChange);
+    ~ConfigWatcher();
+
+    void start(int pollMs = 1000);
+    void stop();
+
+    // Loads the file right away; returns an empty string or the parse error
+    std::string reloadNow();
+
+private:
+    void watchThread(int pollMs);
+
+    std::string path;
+    RecorderConfig base;
+    std::function<void(const RecorderConfig&)> onChange;
+    std::filesystem::file_time_type lastWrite;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+#endif //COURSE_CONFIGWATCHER_H
@@ -0,0 +1,442 @@
+#include "ControlServer.h"
+#include "AudioRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+ControlServer::ControlServer(AudioRecorder& recorder, std::string endpoint)
+    : recorder(recorder), endpoint(std::move(endpoint)), stopThread(false), shutdown(false),
+      ring{}, ringWrite(0), framesDropped(0)
+#ifndef _WIN32
+    , listenFd(-1), wakePipe{-1, -1}, streamingClients(0), framesSignalled(false)
+#endif
+{
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+bool ControlServer::shutdownRequested() const {
+    return shutdown.load();
+}
+
+void ControlServer::setReloadHandler(std::function<std::string()> handler) {
+    reloadHandler = std::move(handler);
+}
+
+std::string ControlServer::defaultEndpoint() {
+#ifdef _WIN32
+    return "\\\\.\\pipe\\course-recorder";
+#else
+    return "/tmp/course-recorder.sock";
+#endif
+}
+
+void ControlServer::publishLevel(const LevelFrame& frame) {
+    std::unique_lock<std::mutex> lock(ringMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring[ringWrite % RING_SIZE] = frame;
+    ++ringWrite;
+    lock.unlock();
+
+#ifdef _WIN32
+    frameCV.notify_all();
+#else
+    // One byte per burst is enough; the server thread clears the flag before reading the ring
+    if (streamingClients.load(std::memory_order_relaxed) > 0 && !framesSignalled.exchange(true)) {
+        char byte = 1;
+        if (write(wakePipe[1], &byte, 1) < 0) {
+            framesSignalled = false;
+        }
+    }
+#endif
+}
+
+uint64_t ControlServer::ringPosition() {
+    std::lock_guard<std::mutex> lock(ringMutex);
+    return ringWrite;
+}
+
+void ControlServer::readFrames(uint64_t& cursor, std::vector<LevelFrame>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(ringMutex);
+    if (ringWrite - cursor > RING_SIZE) {
+        framesDropped.fetch_add(ringWrite - cursor - RING_SIZE, std::memory_order_relaxed);
+        cursor = ringWrite - RING_SIZE;
+    }
+    for (; cursor < ringWrite; ++cursor) {
+        out.push_back(ring[cursor % RING_SIZE]);
+    }
+}
+
+std::string ControlServer::statusLine() const {
+    const RecorderMetrics& metrics = recorder.getMetrics();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "ok running=" << recorder.isRunning()
+        << " armed=" << recorder.isArmed()
+        << " recording=" << recorder.isRecordingActive()
+        << " threshold=" << recorder.getThreshold()
+        << " level=" << recorder.getLatestLevel()
+        << " packets=" << metrics.packets.load()
+        << " frames=" << metrics.framesCaptured.load()
+        << " meter_blocks=" << metrics.meterBlocks.load()
+        << " overruns=" << recorder.getOverruns()
+        << " device_rate_hz=" << metrics.deviceRateMilliHz.load() / 1000.0
+        << " clock_drift_ppm=" << metrics.clockDriftPpb.load() / 1000.0
+        << " clock_jitter_us=" << metrics.clockJitterUs.load()
+        << " level_queue_drops=" << metrics.levelQueueDrops.load()
+        << " stream_drops=" << framesDropped.load()
+        << " saved=" << metrics.recordingsSaved.load()
+        << " duplicates=" << metrics.duplicatesFound.load()
+        << " keywords=" << metrics.keywordDetections.load()
+        << " recovered=" << metrics.recordingsRecovered.load()
+        << " export_sent=" << metrics.exportBatchesSent.load()
+        << " export_bytes=" << metrics.exportBytesSent.load()
+        << " export_failures=" << metrics.exportFailures.load()
+        << " export_backlog=" << metrics.exportBacklog.load()
+        << " power_saving=" << recorder.isPowerSaving()
+        << " power_save_entries=" << metrics.powerSaveEntries.load()
+        << " power_save_ms=" << metrics.powerSaveMs.load()
+        << " cpu_ms_per_hour=" << metrics.cpuMsPerHour.load()
+        << " wakeups_per_hour=" << metrics.wakeupsPerHour.load()
+        << " process_us=" << metrics.processUsLast.load()
+        << " process_us_max=" << metrics.processUsMax.load()
+        << " write_latency_ms=" << metrics.writeLatencyMsLast.load()
+        << " write_latency_ms_max=" << metrics.writeLatencyMsMax.load()
+        << " checkpoint_us=" << metrics.checkpointUsLast.load()
+        << " checkpoint_us_max=" << metrics.checkpointUsMax.load()
+        << " dedup_lookup_us=" << metrics.dedupLookupUsLast.load()
+        << " dedup_lookup_us_max=" << metrics.dedupLookupUsMax.load()
+        << " config_generation=" << metrics.configGeneration.load()
+        << " config_applied_ms=" << metrics.configAppliedUnixMs.load();
+    return out.str();
+}
+
+std::string ControlServer::handleCommand(const std::string& line, bool& streaming) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+
+    if (command == "status") {
+        return statusLine();
+    }
+    if (command == "start") {
+        recorder.setArmed(true);
+        return "ok armed";
+    }
+    if (command == "stop") {
+        recorder.setArmed(false);
+        return "ok disarmed";
+    }
+    if (command == "threshold") {
+        double value;
+        if (!(in >> value)) return "error threshold needs a value in percent";
+        recorder.setThreshold(value);
+        return "ok threshold=" + std::to_string(recorder.getConfig().threshold);
+    }
+    if (command == "reload") {
+        if (!reloadHandler) return "error no config file";
+        std::string error = reloadHandler();
+        if (!error.empty()) return "error " + error;
+        return "ok reload";
+    }
+    if (command == "stream") {
+        streaming = true;
+        return "ok stream";
+    }
+    if (command == "shutdown") {
+        shutdown = true;
+        recorder.requestStop();
+        return "ok shutdown";
+    }
+    return "error unknown command: " + command;
+}
+
+#ifdef _WIN32
+
+bool ControlServer::start() {
+    if (thread.joinable()) return false;
+
+    recorder.setLevelListener([this](const LevelFrame& frame) { publishLevel(frame); });
+    stopThread = false;
+    thread = std::thread(&ControlServer::serverThread, this);
+    std::cout << "Control pipe: " << endpoint << "\n";
+    return true;
+}
+
+void ControlServer::stop() {
+    if (!thread.joinable()) return;
+
+    // Waits out a publishLevel() in progress on the capture thread
+    recorder.setLevelListener(nullptr);
+    stopThread = true;
+
+    // Unblock ConnectNamedPipe with a dummy connection
+    HANDLE dummy = CreateFileA(endpoint.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (dummy != INVALID_HANDLE_VALUE) CloseHandle(dummy);
+    thread.join();
+
+    {
+        // Streaming clients wait for frames under ringMutex
+        std::lock_guard<std::mutex> lock(ringMutex);
+    }
+    frameCV.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(clientMutex);
+        for (void* pipe : clientPipes) {
+            CancelIoEx(static_cast<HANDLE>(pipe), nullptr);
+        }
+    }
+    for (auto& client : clientThreads) {
+        client.join();
+    }
+    clientThreads.clear();
+}
+
+void ControlServer::serverThread() {
+    while (!stopThread) {
+        HANDLE pipe = CreateNamedPipeA(endpoint.c_str(), PIPE_ACCESS_DUPLEX,
+                                       PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                       PIPE_UNLIMITED_INSTANCES, 64 * 1024, 4096, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            std::cerr << "Failed to create control pipe. Error code: " << GetLastError() << std::endl;
+            return;
+        }
+
+        BOOL connected = ConnectNamedPipe(pipe, nullptr) ? TRUE : GetLastError() == ERROR_PIPE_CONNECTED;
+        if (!connected || stopThread) {
+            CloseHandle(pipe);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(clientMutex);
+        clientPipes.push_back(pipe);
+        clientThreads.emplace_back(&ControlServer::clientThread, this, pipe);
+    }
+}
+
+void ControlServer::clientThread(void* handle) {
+    HANDLE pipe = static_cast<HANDLE>(handle);
+    std::string input;
+    bool streaming = false;
+    char buffer[256];
+    DWORD bytes = 0;
+
+    while (!stopThread && !streaming) {
+        if (!ReadFile(pipe, buffer, sizeof(buffer), &bytes, nullptr) || bytes == 0) break;
+        input.append(buffer, bytes);
+
+        size_t pos;
+        while (!streaming && (pos = input.find('\n')) != std::string::npos) {
+            std::string reply = handleCommand(input.substr(0, pos), streaming) + "\n";
+            input.erase(0, pos + 1);
+            WriteFile(pipe, reply.data(), static_cast<DWORD>(reply.size()), &bytes, nullptr);
+        }
+    }
+
+    if (streaming) {
+        uint64_t cursor = ringPosition();
+        std::vector<LevelFrame> frames;
+        while (!stopThread) {
+            {
+                std::unique_lock<std::mutex> lock(ringMutex);
+                frameCV.wait(lock, [&] { return ringWrite != cursor || stopThread; });
+            }
+            readFrames(cursor, frames);
+            if (!frames.empty() &&
+                !WriteFile(pipe, frames.data(), static_cast<DWORD>(frames.size() * sizeof(LevelFrame)), &bytes, nullptr)) {
+                break;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(clientMutex);
+        clientPipes.erase(std::remove(clientPipes.begin(), clientPipes.end(), handle), clientPipes.end());
+    }
+    DisconnectNamedPipe(pipe);
+    CloseHandle(pipe);
+}
+
+#else
+
+bool ControlServer::start() {
+    if (thread.joinable()) return false;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (endpoint.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Control socket path too long: " << endpoint << std::endl;
+        return false;
+    }
+    std::copy(endpoint.begin(), endpoint.end(), address.sun_path);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(endpoint.c_str());
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, 8) != 0 || pipe(wakePipe) != 0) {
+        std::cerr << "Failed to open control socket " << endpoint << ": " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+    // The capture thread writes wake bytes and must never block on a full pipe
+    for (int fd : wakePipe) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+    }
+    streamingClients = 0;
+    framesSignalled = false;
+
+    recorder.setLevelListener([this](const LevelFrame& frame) { publishLevel(frame); });
+    stopThread = false;
+    thread = std::thread(&ControlServer::serverThread, this);
+    std::cout << "Control socket: " << endpoint << "\n";
+    return true;
+}
+
+void ControlServer::stop() {
+    if (thread.joinable()) {
+        // Waits out a publishLevel() in progress, so the wake pipe can be closed below
+        recorder.setLevelListener(nullptr);
+        stopThread = true;
+        char byte = 0;
+        if (write(wakePipe[1], &byte, 1) < 0) {
+            std::cerr << "Failed to wake control thread\n";
+        }
+        thread.join();
+    }
+
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+        unlink(endpoint.c_str());
+    }
+    for (int& fd : wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void ControlServer::serverThread() {
+    struct Client {
+        int fd;
+        std::string input;
+        std::string output;
+        bool streaming = false;
+        uint64_t cursor = 0;
+    };
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    std::vector<LevelFrame> frames;
+
+    // Bytes a streaming client may have queued before frames are dropped for it
+    const size_t maxBacklog = 64 * 1024;
+
+    while (!stopThread) {
+        fds.clear();
+        fds.push_back({wakePipe[0], POLLIN, 0});
+        fds.push_back({listenFd, POLLIN, 0});
+        int streaming = 0;
+        for (auto& client : clients) {
+            short events = POLLIN | (client.output.empty() ? 0 : POLLOUT);
+            fds.push_back({client.fd, events, 0});
+            streaming += client.streaming ? 1 : 0;
+        }
+        streamingClients = streaming;
+
+        // publishLevel() pokes the wake pipe while anyone streams, so there is no polling interval
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {
+            }
+            framesSignalled = false;
+            if (stopThread) break;
+        }
+
+        for (size_t i = 0; i < clients.size(); ++i) {
+            Client& client = clients[i];
+            short revents = fds[i + 2].revents;
+
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[256];
+                ssize_t bytes = recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (bytes <= 0 && !(bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+                    close(client.fd);
+                    client.fd = -1;
+                    continue;
+                }
+                if (bytes > 0) client.input.append(buffer, bytes);
+
+                size_t pos;
+                while (!client.streaming && (pos = client.input.find('\n')) != std::string::npos) {
+                    client.output += handleCommand(client.input.substr(0, pos), client.streaming) + "\n";
+                    client.input.erase(0, pos + 1);
+                    if (client.streaming) client.cursor = ringPosition();
+                }
+            }
+
+            if (client.streaming) {
+                readFrames(client.cursor, frames);
+                size_t room = maxBacklog > client.output.size() ? (maxBacklog - client.output.size()) / sizeof(LevelFrame) : 0;
+                size_t count = std::min(room, frames.size());
+                framesDropped.fetch_add(frames.size() - count, std::memory_order_relaxed);
+                client.output.append(reinterpret_cast<const char*>(frames.data()), count * sizeof(LevelFrame));
+            }
+
+            if (!client.output.empty()) {
+                ssize_t sent = send(client.fd, client.output.data(), client.output.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    close(client.fd);
+                    client.fd = -1;
+                    continue;
+                }
+                if (sent > 0) client.output.erase(0, sent);
+            }
+        }
+
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const Client& client) { return client.fd < 0; }),
+                      clients.end());
+
+        if (fds[1].revents & POLLIN) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                Client client;
+                client.fd = fd;
+                clients.push_back(std::move(client));
+            }
+        }
+    }
+
+    streamingClients = 0;
+    for (auto& client : clients) {
+        close(client.fd);
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef COURSE_CONTROLSERVER_H
+#define COURSE_CONTROLSERVER_H
+
+#include "RecorderMetrics.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AudioRecorder;
+
+// Local control endpoint for daemon mode: a Unix-domain socket on Linux, a
+// named pipe on Windows. Clients send one text command per line and get one
+// "ok ..." / "error ..." line back:
+//
+//   status              counters, level and latency as key=value pairs
+//   start | stop        arm or disarm the trigger (capture keeps running)
+//   threshold <pct>     change the trigger level
+//   reload              re-read the config file (needs a reload handler)
+//   stream              switch the connection to the binary level stream
+//   shutdown            stop the daemon
+//
+// After "stream" the server only sends raw LevelFrame records, one per
+// capture packet. Frames a slow client could not take are skipped and show up
+// as a gap in LevelFrame::sequence.
+class ControlServer {
+public:
+    ControlServer(AudioRecorder& recorder, std::string endpoint);
+    ~ControlServer();
+
+    bool start();
+    void stop();
+    bool shutdownRequested() const;
+    // Runs "reload"; returns an empty string on success, otherwise the error
+    void setReloadHandler(std::function<std::string()> handler);
+
+    static std::string defaultEndpoint();
+
+private:
+    void serverThread();
+    void publishLevel(const LevelFrame& frame);
+    std::string handleCommand(const std::string& line, bool& streaming);
+    std::string statusLine() const;
+    uint64_t ringPosition();
+    void readFrames(uint64_t& cursor, std::vector<LevelFrame>& out);
+
+    AudioRecorder& recorder;
+    std::string endpoint;
+    std::thread thread;
+    std::atomic<bool> stopThread;
+    std::atomic<bool> shutdown;
+    std::function<std::string()> reloadHandler;
+
+    // Written from the capture thread with try_lock only, so streaming never blocks audio
+    static const size_t RING_SIZE = 1024;
+    std::array<LevelFrame, RING_SIZE> ring;
+    uint64_t ringWrite;
+    std::mutex ringMutex;
+    std::atomic<uint64_t> framesDropped;
+
+#ifdef _WIN32
+    void clientThread(void* pipe);
+    std::condition_variable frameCV;  // a frame was published or stop() was called
+    std::vector<std::thread> clientThreads;
+    std::vector<void*> clientPipes;
+    std::mutex clientMutex;
+#else
+    int listenFd;
+    int wakePipe[2];  // stop() and, while someone streams, publishLevel() write here
+    std::atomic<int> streamingClients;
+    std::atomic<bool> framesSignalled;
+#endif
+};
+
+#endif //COURSE_CONTROLSERVER_H
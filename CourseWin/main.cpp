@@ -19,8 +19,12 @@ static COLORREF currentLevelColor = RGB(0, 255, 0); // Зеленый по ум
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
 void levelMonitorThread(HWND hWnd) {
+    double level = 0.0;
     while (isMonitoring && recorder && recorder->isRunning()) {
-        double level = recorder->getLatestLevel();
+        // Спим до следующего измеренного блока; stop() будит поток сразу
+        if (!recorder->getNextLevel(level, 1000)) {
+            continue;
+        }
 
         // Обновляем текст в статическом элементе (кросс-поточный вызов)
         wchar_t levelText[64];
@@ -41,18 +45,17 @@ void levelMonitorThread(HWND hWnd) {
         // Принудительная перерисовка
         InvalidateRect(hLevelStatic, NULL, TRUE);
         UpdateWindow(hLevelStatic);
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 }
 
 void startAudioMonitoring(HWND hWnd) {
     if (!recorder) {
-        recorder = new AudioRecorder();
+        recorder = new AudioRecorder(44100, 1, 16, 10);
     }
 
     if (!isMonitoring) {
         isMonitoring = true;
+        recorder->clearLevels();
         recorder->start();
         monitorThread = std::thread(levelMonitorThread, hWnd);
         SetWindowTextW(hStatic, L"Мониторинг запущен");
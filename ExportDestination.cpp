@@ -0,0 +1,257 @@
+#include "ExportDestination.h"
+#include "WavWriter.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    using Socket = SOCKET;
+    const Socket NO_SOCKET = INVALID_SOCKET;
+
+    void closeSocket(Socket s) {
+        closesocket(s);
+    }
+#else
+    using Socket = int;
+    const Socket NO_SOCKET = -1;
+
+    void closeSocket(Socket s) {
+        ::close(s);
+    }
+#endif
+
+    const int SOCKET_TIMEOUT_MS = 30000;
+
+    // A collector hanging up must fail the upload, not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+    const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+    const int SEND_FLAGS = 0;
+#endif
+
+    Socket connectTo(const std::string& host, const std::string& port, std::string& error) {
+#ifdef _WIN32
+        static bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if (!started) {
+            error = "winsock unavailable";
+            return NO_SOCKET;
+        }
+#endif
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* found = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+            error = "cannot resolve " + host;
+            return NO_SOCKET;
+        }
+
+        Socket s = NO_SOCKET;
+        for (addrinfo* a = found; a && s == NO_SOCKET; a = a->ai_next) {
+            s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (s == NO_SOCKET) continue;
+#ifdef _WIN32
+            DWORD timeout = SOCKET_TIMEOUT_MS;
+#else
+            timeval timeout{SOCKET_TIMEOUT_MS / 1000, 0};
+#endif
+            setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+            setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+            if (connect(s, a->ai_addr, static_cast<int>(a->ai_addrlen)) != 0) {
+                closeSocket(s);
+                s = NO_SOCKET;
+            }
+        }
+        freeaddrinfo(found);
+        if (s == NO_SOCKET) error = "cannot connect to " + host + ":" + port;
+        return s;
+    }
+
+    bool sendAll(Socket s, const char* data, size_t size) {
+        while (size > 0) {
+            int sent = ::send(s, data, static_cast<int>(std::min<size_t>(size, 1 << 20)), SEND_FLAGS);
+            if (sent <= 0) return false;
+            data += sent;
+            size -= sent;
+        }
+        return true;
+    }
+}
+
+void BandwidthLimiter::setRate(int kbps) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bytesPerSecond = kbps * 1000.0 / 8.0;
+    tokens = std::min(tokens, bytesPerSecond);
+}
+
+bool BandwidthLimiter::acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cancelled) {
+        if (bytesPerSecond <= 0.0) return true;
+
+        // The bucket holds one second's worth; larger requests wait for a full bucket
+        auto now = std::chrono::steady_clock::now();
+        tokens = std::min(bytesPerSecond, tokens + std::chrono::duration<double>(now - refilled).count() * bytesPerSecond);
+        refilled = now;
+        double needed = std::min(static_cast<double>(bytes), bytesPerSecond);
+        if (tokens >= needed) {
+            tokens -= static_cast<double>(bytes);
+            return true;
+        }
+        cv.wait_for(lock, std::chrono::duration<double>((needed - tokens) / bytesPerSecond));
+    }
+    return false;
+}
+
+void BandwidthLimiter::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    cv.notify_all();
+}
+
+void BandwidthLimiter::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = false;
+    tokens = 0.0;
+    refilled = std::chrono::steady_clock::now();
+}
+
+DirectoryDestination::DirectoryDestination(std::string directory)
+    : directory(std::move(directory)) {
+}
+
+bool DirectoryDestination::send(const std::string& archivePath, const std::string& name,
+                                BandwidthLimiter& limiter, std::string& error) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::filesystem::path target = std::filesystem::path(directory) / name;
+    std::string partial = target.string() + ".part";
+
+    std::FILE* in = std::fopen(archivePath.c_str(), "rb");
+    if (!in) {
+        error = "cannot read " + archivePath;
+        return false;
+    }
+    std::FILE* out = std::fopen(partial.c_str(), "wb");
+    if (!out) {
+        std::fclose(in);
+        error = "cannot write " + partial;
+        return false;
+    }
+
+    std::vector<char> chunk(CHUNK_SIZE);
+    bool ok = true;
+    while (ok) {
+        size_t got = std::fread(chunk.data(), 1, chunk.size(), in);
+        if (got == 0) break;
+        ok = limiter.acquire(got) && std::fwrite(chunk.data(), 1, got, out) == got;
+    }
+    ok = ok && !std::ferror(in) && std::fflush(out) == 0 && WavWriter::syncFile(out);
+    std::fclose(in);
+    ok = std::fclose(out) == 0 && ok;
+
+    if (ok) {
+        std::filesystem::rename(partial, target, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        error = "copy to " + target.string() + " failed";
+        std::filesystem::remove(partial, ec);
+    }
+    return ok;
+}
+
+HttpDestination::HttpDestination(std::string host, std::string port, std::string path)
+    : host(std::move(host)), port(std::move(port)), path(std::move(path)) {
+}
+
+bool HttpDestination::send(const std::string& archivePath, const std::string& name,
+                           BandwidthLimiter& limiter, std::string& error) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(archivePath, ec);
+    std::FILE* in = ec ? nullptr : std::fopen(archivePath.c_str(), "rb");
+    if (!in) {
+        error = "cannot read " + archivePath;
+        return false;
+    }
+
+    Socket s = connectTo(host, port, error);
+    if (s == NO_SOCKET) {
+        std::fclose(in);
+        return false;
+    }
+
+    std::string request = "PUT " + path + (path.back() == '/' ? "" : "/") + name + " HTTP/1.1\r\n"
+                          "Host: " + host + ":" + port + "\r\n"
+                          "Content-Type: application/x-tar\r\n"
+                          "Content-Length: " + std::to_string(size) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    bool ok = sendAll(s, request.data(), request.size());
+
+    std::vector<char> chunk(CHUNK_SIZE);
+    uintmax_t sent = 0;
+    while (ok) {
+        size_t got = std::fread(chunk.data(), 1, chunk.size(), in);
+        if (got == 0) break;
+        ok = limiter.acquire(got) && sendAll(s, chunk.data(), got);
+        sent += got;
+    }
+    std::fclose(in);
+    if (!ok || sent != size) {
+        closeSocket(s);
+        error = "upload to " + host + ":" + port + " interrupted";
+        return false;
+    }
+
+    // Only the status line matters: "HTTP/1.1 201 Created"
+    std::string response;
+    char buffer[512];
+    while (response.find("\r\n") == std::string::npos) {
+        int got = recv(s, buffer, sizeof(buffer), 0);
+        if (got <= 0) break;
+        response.append(buffer, got);
+    }
+    closeSocket(s);
+
+    size_t space = response.find(' ');
+    if (response.rfind("HTTP/", 0) != 0 || space == std::string::npos || response.compare(space + 1, 1, "2") != 0) {
+        error = "server answered \"" + response.substr(0, response.find("\r\n")) + "\"";
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<ExportDestination> createExportDestination(const std::string& spec) {
+    if (spec.rfind("http://", 0) == 0) {
+        std::string rest = spec.substr(7);
+        size_t slash = rest.find('/');
+        std::string authority = rest.substr(0, slash);
+        std::string path = slash == std::string::npos ? "/" : rest.substr(slash);
+        size_t colon = authority.rfind(':');
+        std::string host = authority.substr(0, colon);
+        std::string port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+        if (host.empty() || port.empty()) return nullptr;
+        return std::make_unique<HttpDestination>(host, port, path);
+    }
+    if (spec.rfind("dir:", 0) == 0) {
+        return spec.size() > 4 ? std::make_unique<DirectoryDestination>(spec.substr(4)) : nullptr;
+    }
+    if (spec.empty() || spec.find("://") != std::string::npos) return nullptr;
+    return std::make_unique<DirectoryDestination>(spec);
+}
@@ -0,0 +1,76 @@
+#ifndef COURSE_EXPORTDESTINATION_H
+#define COURSE_EXPORTDESTINATION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Token bucket shared by all export workers. acquire() blocks until the
+// bytes may be sent and returns false once cancel() was called.
+class BandwidthLimiter {
+public:
+    void setRate(int kbps);  // 0 is unlimited
+    bool acquire(size_t bytes);
+    void cancel();
+    void reset();
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    double bytesPerSecond = 0.0;
+    double tokens = 0.0;
+    std::chrono::steady_clock::time_point refilled = std::chrono::steady_clock::now();
+    bool cancelled = false;
+};
+
+// Where finished batches go. send() delivers one archive under the given
+// name and must not leave a partial file visible at the destination.
+class ExportDestination {
+public:
+    virtual ~ExportDestination() = default;
+
+    virtual bool send(const std::string& archivePath, const std::string& name,
+                      BandwidthLimiter& limiter, std::string& error) = 0;
+    virtual const char* kind() const = 0;
+
+    // Reads the archive in chunks the limiter has cleared
+    static const size_t CHUNK_SIZE = 64 * 1024;
+};
+
+// Copies into a directory, writing "<name>.part" and renaming it when complete
+class DirectoryDestination : public ExportDestination {
+public:
+    explicit DirectoryDestination(std::string directory);
+
+    bool send(const std::string& archivePath, const std::string& name,
+              BandwidthLimiter& limiter, std::string& error) override;
+    const char* kind() const override { return "dir"; }
+
+private:
+    std::string directory;
+};
+
+// "PUT <path>/<name>" with a Content-Length body; any 2xx status is success.
+// Plain HTTP only, meant for a collector on the local network or a test sink.
+class HttpDestination : public ExportDestination {
+public:
+    HttpDestination(std::string host, std::string port, std::string path);
+
+    bool send(const std::string& archivePath, const std::string& name,
+              BandwidthLimiter& limiter, std::string& error) override;
+    const char* kind() const override { return "http"; }
+
+private:
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+// "http://host[:port]/path", "dir:<directory>" or a bare directory; nullptr if malformed
+std::unique_ptr<ExportDestination> createExportDestination(const std::string& spec);
+
+#endif //COURSE_EXPORTDESTINATION_H
@@ -0,0 +1,332 @@
+#include "Exporter.h"
+#include "WavWriter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    const auto PARK_TIME = std::chrono::minutes(5);
+    const auto MAX_BACKOFF = std::chrono::seconds(60);
+    const size_t TAR_BLOCK = 512;
+    // Largest value of an 11-digit octal field, just under 8 GiB
+    const uint64_t MAX_OCTAL_FIELD = 077777777777ULL;
+
+    // Zero-padded octal digits filling all but the last byte of a field, which stays NUL
+    void putOctal(char* field, size_t width, uint64_t value) {
+        for (size_t i = width - 1; i-- > 0; value >>= 3) {
+            field[i] = static_cast<char>('0' + (value & 7));
+        }
+    }
+
+    // ustar header for a regular file; names longer than 100 bytes are cut
+    void writeTarHeader(std::FILE* out, const std::string& name, uint64_t size, int64_t mtime) {
+        char header[TAR_BLOCK] = {};
+        std::memcpy(header, name.data(), std::min<size_t>(name.size(), 100));
+        putOctal(header + 100, 8, 0644);
+        putOctal(header + 108, 8, 0);
+        putOctal(header + 116, 8, 0);
+        if (size <= MAX_OCTAL_FIELD) {
+            putOctal(header + 124, 12, size);
+        } else {
+            // GNU base-256: a set top bit, then the size big-endian in the other 11 bytes
+            header[124] = static_cast<char>(0x80);
+            for (int i = 11; i > 0; --i, size >>= 8) {
+                header[124 + i] = static_cast<char>(size & 0xff);
+            }
+        }
+        putOctal(header + 136, 12, std::min<uint64_t>(static_cast<uint64_t>(std::max<int64_t>(mtime, 0)), MAX_OCTAL_FIELD));
+        header[156] = '0';
+        std::memcpy(header + 257, "ustar", 6);
+        std::memcpy(header + 263, "00", 2);
+
+        // The checksum is taken with its own field filled with spaces
+        std::memset(header + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (unsigned char c : header) checksum += c;
+        std::snprintf(header + 148, 8, "%06o", checksum);
+        std::fwrite(header, 1, TAR_BLOCK, out);
+    }
+
+    void padTarEntry(std::FILE* out, uint64_t size) {
+        static const char zeros[TAR_BLOCK] = {};
+        std::fwrite(zeros, 1, (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK, out);
+    }
+}
+
+Exporter::Exporter(RecorderMetrics& metrics)
+    : metrics(metrics) {
+}
+
+Exporter::~Exporter() {
+    stop();
+}
+
+bool Exporter::start(const RecorderConfig& config) {
+    stop();
+
+    destination = createExportDestination(config.exportTo);
+    if (!destination) {
+        std::cerr << "Unknown export destination: " << config.exportTo << "\n";
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(config.exportSpool, ec);
+    if (ec) {
+        std::cerr << "Cannot create export spool " << config.exportSpool << "\n";
+        destination.reset();
+        return false;
+    }
+
+    // Whatever an earlier run packed but did not deliver goes first
+    std::vector<std::string> leftovers;
+    for (const auto& item : std::filesystem::directory_iterator(config.exportSpool, ec)) {
+        std::string extension = item.path().extension().string();
+        if (extension == ".tar") leftovers.push_back(item.path().string());
+        if (extension == ".part") std::filesystem::remove(item.path(), ec);
+    }
+    std::sort(leftovers.begin(), leftovers.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        settings = config;
+        stopping = false;
+        pending.clear();
+        parked.clear();
+        ready.assign(leftovers.begin(), leftovers.end());
+        metrics.exportBacklog.store(static_cast<uint32_t>(ready.size()), std::memory_order_relaxed);
+    }
+    limiter.reset();
+    limiter.setRate(config.exportKbps);
+
+    for (int i = 0; i < config.exportConcurrency; ++i) {
+        workers.emplace_back(&Exporter::workerThread, this);
+    }
+    std::cout << "Exporting to " << destination->kind() << " " << config.exportTo;
+    if (!leftovers.empty()) std::cout << ", " << leftovers.size() << " batch(es) left from the last run";
+    std::cout << "\n";
+    return true;
+}
+
+void Exporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    limiter.cancel();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    if (!pending.empty()) {
+        packBatch(pending);
+        pending.clear();
+    }
+    ready.clear();
+    parked.clear();
+    destination.reset();
+}
+
+void Exporter::applyConfig(const RecorderConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        settings.exportBatchFiles = config.exportBatchFiles;
+        settings.exportBatchMs = config.exportBatchMs;
+        settings.exportRetries = config.exportRetries;
+        settings.exportDelete = config.exportDelete;
+        settings.exportKbps = config.exportKbps;
+    }
+    limiter.setRate(config.exportKbps);
+    cv.notify_all();
+}
+
+void Exporter::add(const RecordingEntry& entry) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty()) pendingSince = std::chrono::steady_clock::now();
+        pending.push_back(entry);
+    }
+    cv.notify_one();
+}
+
+bool Exporter::batchDue(std::chrono::steady_clock::time_point now) const {
+    if (pending.empty()) return false;
+    return pending.size() >= static_cast<size_t>(settings.exportBatchFiles) ||
+           now - pendingSince >= std::chrono::milliseconds(settings.exportBatchMs);
+}
+
+void Exporter::workerThread() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = parked.begin(); it != parked.end();) {
+            if (it->first <= now) {
+                ready.push_back(it->second);
+                it = parked.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (batchDue(now)) {
+            std::vector<RecordingEntry> batch;
+            batch.swap(pending);
+            lock.unlock();
+            std::string archive = packBatch(batch);
+            lock.lock();
+            if (!archive.empty()) {
+                ready.push_back(archive);
+                cv.notify_all();
+            }
+            continue;
+        }
+
+        if (!ready.empty()) {
+            std::string archive = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            bool delivered = ship(archive);
+            lock.lock();
+            if (!delivered && !stopping) {
+                parked.emplace_back(std::chrono::steady_clock::now() + PARK_TIME, archive);
+            }
+            continue;
+        }
+
+        // Sleep until something arrives, the open batch times out or a parked archive is due
+        auto wake = std::chrono::steady_clock::time_point::max();
+        if (!pending.empty()) wake = pendingSince + std::chrono::milliseconds(settings.exportBatchMs);
+        for (const auto& item : parked) {
+            wake = std::min(wake, item.first);
+        }
+        if (wake == std::chrono::steady_clock::time_point::max()) {
+            cv.wait(lock);
+        } else {
+            cv.wait_until(lock, wake);
+        }
+    }
+}
+
+std::string Exporter::packBatch(const std::vector<RecordingEntry>& entries) {
+    bool removeOriginals;
+    std::filesystem::path spool;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        removeOriginals = settings.exportDelete != 0;
+        spool = settings.exportSpool;
+        auto unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        name = "batch_" + std::to_string(unixMs) + "_" + std::to_string(batchSequence++) + ".tar";
+    }
+    std::filesystem::path target = spool / name;
+    std::string partial = target.string() + ".part";
+
+    std::FILE* out = std::fopen(partial.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Cannot create export batch " << partial << "\n";
+        return "";
+    }
+
+    auto mtime = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string manifest;
+    std::vector<char> chunk(ExportDestination::CHUNK_SIZE);
+    std::vector<std::string> packed;
+    for (const RecordingEntry& entry : entries) {
+        std::FILE* in = std::fopen(entry.file.c_str(), "rb");
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(entry.file, ec);
+        if (!in || ec) {
+            if (in) std::fclose(in);
+            std::cerr << "Cannot export " << entry.file << ", skipping it\n";
+            continue;
+        }
+
+        RecordingEntry local = entry;
+        local.file = std::filesystem::path(entry.file).filename().string();
+        manifest += RecordingIndex::formatLine(local);
+
+        writeTarHeader(out, local.file, size, mtime);
+        uintmax_t copied = 0;
+        for (size_t got; copied < size && (got = std::fread(chunk.data(), 1, chunk.size(), in)) > 0;) {
+            got = static_cast<size_t>(std::min<uintmax_t>(got, size - copied));
+            std::fwrite(chunk.data(), 1, got, out);
+            copied += got;
+        }
+        std::fclose(in);
+        // The header promised size bytes; a file that shrank meanwhile is zero padded
+        for (; copied < size; ++copied) std::fputc(0, out);
+        padTarEntry(out, size);
+        packed.push_back(entry.file);
+    }
+
+    writeTarHeader(out, "manifest.txt", manifest.size(), mtime);
+    std::fwrite(manifest.data(), 1, manifest.size(), out);
+    padTarEntry(out, manifest.size());
+    std::vector<char> end(2 * TAR_BLOCK, 0);
+    std::fwrite(end.data(), 1, end.size(), out);
+
+    bool ok = !std::ferror(out) && std::fflush(out) == 0 && WavWriter::syncFile(out);
+    ok = std::fclose(out) == 0 && ok;
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(partial, target, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::cerr << "Cannot write export batch " << target.string() << "\n";
+        std::filesystem::remove(partial, ec);
+        return "";
+    }
+
+    // The synced archive is the copy that gets delivered from here on
+    if (removeOriginals) {
+        for (const std::string& file : packed) {
+            std::filesystem::remove(file, ec);
+        }
+    }
+    metrics.exportBacklog.fetch_add(1, std::memory_order_relaxed);
+    return target.string();
+}
+
+bool Exporter::ship(const std::string& archive) {
+    std::string name = std::filesystem::path(archive).filename().string();
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(archive, ec);
+    if (ec) {
+        // Removed from the spool by hand; nothing left to deliver
+        metrics.exportBacklog.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    for (int attempt = 0;; ++attempt) {
+        std::string error;
+        auto started = std::chrono::steady_clock::now();
+        if (destination->send(archive, name, limiter, error)) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            std::filesystem::remove(archive, ec);
+            metrics.exportBatchesSent.fetch_add(1, std::memory_order_relaxed);
+            metrics.exportBytesSent.fetch_add(size, std::memory_order_relaxed);
+            metrics.exportBacklog.fetch_sub(1, std::memory_order_relaxed);
+            std::cout << "Exported " << name << " (" << size / 1024 << " KiB, " << elapsed << " ms)\n";
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopping) return false;
+        metrics.exportFailures.fetch_add(1, std::memory_order_relaxed);
+        if (attempt >= settings.exportRetries) {
+            std::cerr << "Export of " << name << " failed (" << error << "), trying again later\n";
+            return false;
+        }
+        auto backoff = std::min<std::chrono::seconds>(std::chrono::seconds(1LL << std::min(attempt, 16)), MAX_BACKOFF);
+        std::cerr << "Export of " << name << " failed (" << error << "), retrying\n";
+        cv.wait_for(lock, backoff, [this] { return stopping; });
+        if (stopping) return false;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef COURSE_EXPORTER_H
+#define COURSE_EXPORTER_H
+
+#include "ExportDestination.h"
+#include "RecorderConfig.h"
+#include "RecorderMetrics.h"
+#include "RecordingIndex.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ships finished recordings. The recorder hands over every saved file;
+// files are collected into batches of export_batch_files (or whatever
+// arrived within export_batch_ms) and packed into a tar archive in the spool
+// directory together with a manifest of their index lines. Up to
+// export_concurrency workers send archives to the destination, sharing the
+// export_kbps budget, and retry with exponential backoff. An archive only
+// leaves the spool once it was delivered, so batches cut off by stop() are
+// sent again on the next start.
+class Exporter {
+public:
+    explicit Exporter(RecorderMetrics& metrics);
+    ~Exporter();
+
+    Exporter(const Exporter&) = delete;
+    Exporter& operator=(const Exporter&) = delete;
+
+    bool start(const RecorderConfig& config);
+    // Packs the files still waiting into the spool and abandons running uploads
+    void stop();
+    // Batch size, bandwidth, retries and deletion are hot
+    void applyConfig(const RecorderConfig& config);
+
+    void add(const RecordingEntry& entry);
+
+private:
+    void workerThread();
+    bool batchDue(std::chrono::steady_clock::time_point now) const;
+    std::string packBatch(const std::vector<RecordingEntry>& entries);
+    bool ship(const std::string& archive);
+
+    RecorderMetrics& metrics;
+    std::unique_ptr<ExportDestination> destination;
+    BandwidthLimiter limiter;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    RecorderConfig settings;
+    std::vector<RecordingEntry> pending;
+    std::chrono::steady_clock::time_point pendingSince;
+    std::deque<std::string> ready;  // archives in the spool, oldest first
+    // Archives that used up their retries rest before the next round, so
+    // one bad batch cannot hold up the others
+    std::vector<std::pair<std::chrono::steady_clock::time_point, std::string>> parked;
+    uint64_t batchSequence = 0;
+};
+
+#endif //COURSE_EXPORTER_H
@@ -0,0 +1,29 @@
+#include "Fft.h"
+#include <utility>
+
+Fft::Fft(size_t size) : twiddles(size / 2) {
+    const double PI = 3.14159265358979323846;
+    for (size_t i = 0; i < size / 2; ++i) {
+        twiddles[i] = std::polar(1.0f, static_cast<float>(-2.0 * PI * i / size));
+    }
+}
+
+void Fft::transform(std::vector<std::complex<float>>& data) const {
+    const size_t n = data.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(data[i], data[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t step = n / len;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < len / 2; ++k) {
+                std::complex<float> t = data[i + k + len / 2] * twiddles[k * step];
+                data[i + k + len / 2] = data[i + k] - t;
+                data[i + k] += t;
+            }
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef COURSE_FFT_H
+#define COURSE_FFT_H
+
+#include <complex>
+#include <vector>
+
+// In-place radix-2 FFT with precomputed twiddles; size must be a power of two
+class Fft {
+public:
+    explicit Fft(size_t size);
+
+    size_t size() const { return twiddles.size() * 2; }
+    void transform(std::vector<std::complex<float>>& data) const;
+
+private:
+    std::vector<std::complex<float>> twiddles;
+};
+
+#endif //COURSE_FFT_H
@@ -0,0 +1,239 @@
+#include "FingerprintIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    // A clip counts as a duplicate when enough of its hashes line up at one offset
+    const int MIN_VOTES = 10;
+    const double MIN_VOTE_RATIO = 0.1;
+
+    // Out-of-window entries are dropped after this many adds
+    const size_t PRUNE_EVERY = 1024;
+
+    bool openFile(std::fstream& file, const std::string& name) {
+        file.open(name, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            file.clear();
+            file.open(name, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+        return file.is_open();
+    }
+
+    uint32_t bucketOf(uint32_t hash, int bits) {
+        // Hashes are structured (bin fields), spread them before taking the top bits
+        return (hash * 2654435761u) >> (32 - bits);
+    }
+}
+
+FingerprintIndex::FingerprintIndex()
+    : hashEnd(0), firstLoaded(0), bucketBits(0), entryCount(0), addsSincePrune(0), lastNotBefore(0) {
+}
+
+FingerprintIndex::~FingerprintIndex() {
+    close();
+}
+
+bool FingerprintIndex::open(const std::string& path, int64_t notBeforeUnixMs) {
+    close();
+
+    if (!openFile(clipFile, path + ".clips") || !openFile(hashFile, path + ".hashes")) {
+        std::cerr << "Failed to open fingerprint index " << path << "\n";
+        close();
+        return false;
+    }
+
+    std::vector<ClipRecord> records;
+    clipFile.seekg(0, std::ios::end);
+    records.resize(static_cast<size_t>(clipFile.tellg()) / sizeof(ClipRecord));
+    clipFile.seekg(0);
+    clipFile.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(ClipRecord));
+    if (!clipFile) {
+        std::cerr << "Failed to read fingerprint index " << path << "\n";
+        close();
+        return false;
+    }
+
+    hashEnd = records.empty() ? 0 : records.back().hashOffset + records.back().hashCount * sizeof(FingerprintHash);
+    hashFile.seekg(0, std::ios::end);
+    if (static_cast<uint64_t>(hashFile.tellg()) != hashEnd) {
+        // Hashes of a clip whose record never made it to disk
+        hashFile.close();
+        std::error_code ec;
+        std::filesystem::resize_file(path + ".hashes", hashEnd, ec);
+        if (ec || !openFile(hashFile, path + ".hashes")) {
+            std::cerr << "Failed to repair fingerprint index " << path << "\n";
+            close();
+            return false;
+        }
+    }
+
+    clipTimes.reserve(records.size());
+    for (const ClipRecord& record : records) {
+        clipTimes.push_back(record.unixMs);
+    }
+
+    // Clips are appended in time order, so the window is a suffix of the file
+    firstLoaded = static_cast<uint32_t>(std::lower_bound(clipTimes.begin(), clipTimes.end(), notBeforeUnixMs) - clipTimes.begin());
+    size_t windowHashes = 0;
+    for (uint32_t id = firstLoaded; id < records.size(); ++id) {
+        windowHashes += records[id].hashCount;
+    }
+    bucketBits = MIN_BUCKET_BITS;
+    while (bucketBits < MAX_BUCKET_BITS && windowHashes > (size_t(1) << bucketBits) * ENTRIES_PER_BUCKET) {
+        ++bucketBits;
+    }
+    buckets.assign(size_t(1) << bucketBits, {});
+    std::vector<FingerprintHash> hashes;
+    for (uint32_t id = firstLoaded; id < records.size(); ++id) {
+        hashes.resize(records[id].hashCount);
+        hashFile.seekg(static_cast<std::streamoff>(records[id].hashOffset));
+        hashFile.read(reinterpret_cast<char*>(hashes.data()), hashes.size() * sizeof(FingerprintHash));
+        clipNames.emplace_back(records[id].name, strnlen(records[id].name, sizeof(records[id].name)));
+        insert(id, hashes);
+    }
+    hashFile.clear();
+
+    this->path = path;
+    lastNotBefore = notBeforeUnixMs;
+    return true;
+}
+
+void FingerprintIndex::close() {
+    clipFile.close();
+    hashFile.close();
+    hashEnd = 0;
+    clipTimes.clear();
+    clipNames.clear();
+    firstLoaded = 0;
+    buckets.clear();
+    bucketBits = 0;
+    entryCount = 0;
+    addsSincePrune = 0;
+    path.clear();
+}
+
+bool FingerprintIndex::isOpen() const {
+    return !path.empty();
+}
+
+const std::string& FingerprintIndex::getPath() const {
+    return path;
+}
+
+size_t FingerprintIndex::getClipCount() const {
+    return clipTimes.size();
+}
+
+void FingerprintIndex::insert(uint32_t clipId, const std::vector<FingerprintHash>& hashes) {
+    entryCount += hashes.size();
+    int bits = bucketBits;
+    while (bits < MAX_BUCKET_BITS && entryCount > (size_t(1) << bits) * ENTRIES_PER_BUCKET) {
+        ++bits;
+    }
+    if (bits != bucketBits) resize(bits);
+
+    for (const FingerprintHash& h : hashes) {
+        buckets[bucketOf(h.hash, bucketBits)].push_back({h.hash, clipId, h.frame});
+    }
+}
+
+void FingerprintIndex::resize(int bits) {
+    // A bucket of the larger table draws from a single old bucket, so clip ids stay ascending
+    std::vector<std::vector<Entry>> old(size_t(1) << bits);
+    old.swap(buckets);
+    bucketBits = bits;
+    for (const auto& bucket : old) {
+        for (const Entry& entry : bucket) {
+            buckets[bucketOf(entry.hash, bucketBits)].push_back(entry);
+        }
+    }
+}
+
+void FingerprintIndex::prune(int64_t notBeforeUnixMs) {
+    uint32_t firstRecent = static_cast<uint32_t>(std::lower_bound(clipTimes.begin(), clipTimes.end(), notBeforeUnixMs) - clipTimes.begin());
+    if (firstRecent <= firstLoaded) return;
+
+    // Entries are appended per clip, so every bucket holds clip ids in ascending order
+    for (auto& bucket : buckets) {
+        auto keep = std::find_if(bucket.begin(), bucket.end(), [&](const Entry& e) { return e.clipId >= firstRecent; });
+        entryCount -= keep - bucket.begin();
+        bucket.erase(bucket.begin(), keep);
+    }
+    clipNames.erase(clipNames.begin(), clipNames.begin() + std::min<size_t>(firstRecent - firstLoaded, clipNames.size()));
+    firstLoaded = firstRecent;
+}
+
+bool FingerprintIndex::findMatch(const std::vector<FingerprintHash>& hashes, int64_t notBeforeUnixMs, Match& match) {
+    if (!isOpen() || hashes.empty()) return false;
+    lastNotBefore = notBeforeUnixMs;
+
+    // Long clips only need a sample of their hashes to be recognised
+    size_t stride = std::max<size_t>(1, hashes.size() / MAX_QUERY_HASHES);
+    int queried = 0;
+
+    // One key per agreeing (clip, time offset); the longest run after sorting wins
+    candidates.clear();
+    for (size_t i = 0; i < hashes.size(); i += stride) {
+        const FingerprintHash& query = hashes[i];
+        ++queried;
+
+        for (const Entry& entry : buckets[bucketOf(query.hash, bucketBits)]) {
+            if (entry.hash != query.hash || clipTimes[entry.clipId] < notBeforeUnixMs) continue;
+            int32_t delta = static_cast<int32_t>(entry.frame - query.frame);
+            candidates.push_back((static_cast<uint64_t>(entry.clipId) << 32) | static_cast<uint32_t>(delta));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    uint64_t bestKey = 0;
+    int bestVotes = 0;
+    for (size_t i = 0; i < candidates.size();) {
+        size_t run = i;
+        while (run < candidates.size() && candidates[run] == candidates[i]) ++run;
+        if (static_cast<int>(run - i) > bestVotes) {
+            bestVotes = static_cast<int>(run - i);
+            bestKey = candidates[i];
+        }
+        i = run;
+    }
+    if (bestVotes < std::max(MIN_VOTES, static_cast<int>(queried * MIN_VOTE_RATIO))) {
+        return false;
+    }
+
+    match.clipId = static_cast<uint32_t>(bestKey >> 32);
+    match.name = clipNames[match.clipId - firstLoaded];
+    match.votes = bestVotes;
+    match.queried = queried;
+    return true;
+}
+
+uint32_t FingerprintIndex::add(const std::string& name, int64_t unixMs, const std::vector<FingerprintHash>& hashes) {
+    uint32_t clipId = static_cast<uint32_t>(clipTimes.size());
+
+    // Hashes first: a clip record must never point past the end of the hash file
+    hashFile.seekp(static_cast<std::streamoff>(hashEnd));
+    hashFile.write(reinterpret_cast<const char*>(hashes.data()), hashes.size() * sizeof(FingerprintHash));
+    hashFile.flush();
+
+    ClipRecord record{};
+    record.unixMs = std::max(unixMs, clipTimes.empty() ? unixMs : clipTimes.back());
+    record.hashOffset = hashEnd;
+    record.hashCount = static_cast<uint32_t>(hashes.size());
+    std::strncpy(record.name, name.c_str(), sizeof(record.name) - 1);
+    clipFile.seekp(static_cast<std::streamoff>(clipId) * sizeof(ClipRecord));
+    clipFile.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    clipFile.flush();
+
+    hashEnd += hashes.size() * sizeof(FingerprintHash);
+    clipTimes.push_back(record.unixMs);
+    clipNames.push_back(name);
+    insert(clipId, hashes);
+
+    if (++addsSincePrune >= PRUNE_EVERY) {
+        addsSincePrune = 0;
+        prune(lastNotBefore);
+    }
+    return clipId;
+}
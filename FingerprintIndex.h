@@ -0,0 +1,85 @@
+#ifndef COURSE_FINGERPRINTINDEX_H
+#define COURSE_FINGERPRINTINDEX_H
+
+#include "Fingerprinter.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Persistent fingerprint store with an inverted hash table for recent clips.
+// Two append-only files share the path prefix:
+//
+//   <path>.clips     one ClipRecord per clip, the clip id is the record index
+//   <path>.hashes    every clip's FingerprintHash list, back to back
+//
+// Duplicates are only searched within a time window, so open() loads just
+// the clips recorded since notBeforeUnixMs into an in-memory table keyed by
+// hash; older clips stay on disk and cost nothing. Lookups never touch the
+// disk and scale with the number of clips inside the window, not with the
+// archive. A clip record is written after its hashes, so a crash in between
+// leaves trailing hashes that open() truncates away.
+class FingerprintIndex {
+public:
+    struct Match {
+        uint32_t clipId = 0;
+        std::string name;
+        int votes = 0;      // hashes agreeing on one time offset
+        int queried = 0;    // hashes looked up
+    };
+
+    FingerprintIndex();
+    ~FingerprintIndex();
+
+    bool open(const std::string& path, int64_t notBeforeUnixMs);
+    void close();
+    bool isOpen() const;
+    const std::string& getPath() const;
+    size_t getClipCount() const;
+
+    // Best earlier clip recorded at or after notBeforeUnixMs, if it matches well enough
+    bool findMatch(const std::vector<FingerprintHash>& hashes, int64_t notBeforeUnixMs, Match& match);
+    uint32_t add(const std::string& name, int64_t unixMs, const std::vector<FingerprintHash>& hashes);
+
+private:
+    struct ClipRecord {
+        int64_t unixMs;
+        uint64_t hashOffset;
+        uint32_t hashCount;
+        char name[44];  // file name, truncated
+    };
+    static_assert(sizeof(ClipRecord) == 64, "ClipRecord is an on-disk record");
+
+    struct Entry {
+        uint32_t hash;
+        uint32_t clipId;
+        uint32_t frame;
+    };
+
+    // The table starts at the size the window needs and doubles as clips are added
+    static const int MIN_BUCKET_BITS = 10;
+    static const int MAX_BUCKET_BITS = 20;
+    static const size_t ENTRIES_PER_BUCKET = 2;
+    static const size_t MAX_QUERY_HASHES = 512;
+
+    void insert(uint32_t clipId, const std::vector<FingerprintHash>& hashes);
+    void resize(int bits);
+    void prune(int64_t notBeforeUnixMs);
+
+    std::string path;
+    std::fstream clipFile;
+    std::fstream hashFile;
+    uint64_t hashEnd;
+
+    std::vector<int64_t> clipTimes;                  // every clip, for window checks
+    std::vector<std::string> clipNames;              // recent clips only, by clipId - firstLoaded
+    uint32_t firstLoaded;
+    std::vector<std::vector<Entry>> buckets;
+    int bucketBits;
+    size_t entryCount;
+    std::vector<uint64_t> candidates;
+    size_t addsSincePrune;
+    int64_t lastNotBefore;
+};
+
+#endif //COURSE_FINGERPRINTINDEX_H
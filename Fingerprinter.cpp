@@ -0,0 +1,115 @@
+#include "Fingerprinter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double PI = 3.14159265358979323846;
+
+    // Band edges in Hz; one candidate peak per band per frame
+    const double BANDS_HZ[] = {150, 300, 600, 1000, 1600, 2500, 4000, 6000};
+
+    const float PEAK_FLOOR = 0.5f;        // about -54 dBFS for a full-band Hann frame
+    const float THRESHOLD_DECAY = 0.97f;  // per frame, halves in about a quarter second at 44.1 kHz
+    const uint32_t TARGET_FRAMES = 63;    // fits the 6-bit frame delta
+    const int TARGET_BINS = 96;
+    const uint8_t PAIRS_PER_ANCHOR = 3;
+    const uint32_t REPEAT_FRAMES = 8;     // a steady tone repeats its hash every frame, keep one
+}
+
+Fingerprinter::Fingerprinter(int sampleRate, int channels)
+    : channels(std::max(channels, 1)), fft(FFT_SIZE), window(FFT_SIZE), spectrum(FFT_SIZE),
+      fold(0.0f), foldCount(0), frameIndex(0) {
+    for (int i = 0; i < FFT_SIZE; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * i / FFT_SIZE));
+    }
+    for (double hz : BANDS_HZ) {
+        int bin = static_cast<int>(hz * FFT_SIZE / sampleRate);
+        if (bin >= FFT_SIZE / 2) break;
+        bandEdges.push_back(std::max(bin, 1));
+    }
+    bandThreshold.assign(bandEdges.empty() ? 0 : bandEdges.size() - 1, 0.0f);
+    frame.reserve(FFT_SIZE);
+}
+
+void Fingerprinter::reset() {
+    std::fill(bandThreshold.begin(), bandThreshold.end(), 0.0f);
+    frame.clear();
+    fold = 0.0f;
+    foldCount = 0;
+    frameIndex = 0;
+    recentPeaks.clear();
+    lastEmitted.clear();
+    hashes.clear();
+}
+
+const std::vector<FingerprintHash>& Fingerprinter::getHashes() const {
+    return hashes;
+}
+
+void Fingerprinter::push(const short* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        fold += samples[i];
+        if (++foldCount < channels) continue;
+
+        frame.push_back(fold / (32768.0f * channels));
+        fold = 0.0f;
+        foldCount = 0;
+
+        if (frame.size() == FFT_SIZE) {
+            analyseFrame();
+            frame.erase(frame.begin(), frame.begin() + HOP);
+        }
+    }
+}
+
+void Fingerprinter::analyseFrame() {
+    for (int i = 0; i < FFT_SIZE; ++i) {
+        spectrum[i] = frame[i] * window[i];
+    }
+    fft.transform(spectrum);
+
+    std::vector<Peak> peaks;
+    for (size_t b = 0; b + 1 < bandEdges.size(); ++b) {
+        int best = bandEdges[b];
+        float bestMag = 0.0f;
+        for (int bin = bandEdges[b]; bin < bandEdges[b + 1]; ++bin) {
+            float mag = std::abs(spectrum[bin]);
+            if (mag > bestMag) {
+                bestMag = mag;
+                best = bin;
+            }
+        }
+
+        bandThreshold[b] *= THRESHOLD_DECAY;
+        if (bestMag > PEAK_FLOOR && bestMag > bandThreshold[b]) {
+            bandThreshold[b] = bestMag;
+            peaks.push_back({frameIndex, static_cast<uint16_t>(best), 0});
+        }
+    }
+
+    // Pair the new peaks as targets of the anchors still inside their zone
+    recentPeaks.erase(std::remove_if(recentPeaks.begin(), recentPeaks.end(), [&](const Peak& anchor) {
+        return frameIndex - anchor.frame > TARGET_FRAMES || anchor.pairs >= PAIRS_PER_ANCHOR;
+    }), recentPeaks.end());
+
+    for (Peak& anchor : recentPeaks) {
+        for (const Peak& target : peaks) {
+            if (anchor.pairs >= PAIRS_PER_ANCHOR) break;
+            if (std::abs(target.bin - anchor.bin) > TARGET_BINS) continue;
+
+            uint32_t delta = frameIndex - anchor.frame;
+            uint32_t hash = (static_cast<uint32_t>(anchor.bin) << 15) | (static_cast<uint32_t>(target.bin) << 6) | delta;
+            ++anchor.pairs;
+
+            auto last = lastEmitted.find(hash);
+            if (last != lastEmitted.end() && anchor.frame - last->second < REPEAT_FRAMES) {
+                last->second = anchor.frame;
+                continue;
+            }
+            lastEmitted[hash] = anchor.frame;
+            hashes.push_back({hash, anchor.frame});
+        }
+    }
+    recentPeaks.insert(recentPeaks.end(), peaks.begin(), peaks.end());
+    ++frameIndex;
+}
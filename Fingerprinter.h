@@ -0,0 +1,58 @@
+#ifndef COURSE_FINGERPRINTER_H
+#define COURSE_FINGERPRINTER_H
+
+#include "Fft.h"
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct FingerprintHash {
+    uint32_t hash;   // anchor bin (9 bits) | target bin (9 bits) | frame delta (6 bits)
+    uint32_t frame;  // analysis frame of the anchor peak
+};
+
+// Streaming landmark fingerprint. Audio is folded to mono and analysed in
+// 1024-point frames with 50% overlap; each frame contributes at most a few
+// spectral peaks (strongest bin per band that beats a decaying per-band
+// threshold), and every peak is paired with the next peaks in a short
+// target zone. The pair hashes survive gain changes and moderate noise, so
+// two takes of the same alarm produce many hashes with a common time offset.
+class Fingerprinter {
+public:
+    static const int FFT_SIZE = 1024;
+    static const int HOP = FFT_SIZE / 2;
+
+    Fingerprinter(int sampleRate, int channels);
+
+    void push(const short* samples, size_t count);
+    const std::vector<FingerprintHash>& getHashes() const;
+    void reset();
+
+private:
+    struct Peak {
+        uint32_t frame;
+        uint16_t bin;
+        uint8_t pairs;
+    };
+
+    void analyseFrame();
+
+    int channels;
+    Fft fft;
+    std::vector<int> bandEdges;
+    std::vector<float> window;
+    std::vector<std::complex<float>> spectrum;
+    std::vector<float> frame;
+    std::vector<float> bandThreshold;
+
+    float fold;
+    int foldCount;
+    uint32_t frameIndex;
+    std::vector<Peak> recentPeaks;
+    std::unordered_map<uint32_t, uint32_t> lastEmitted;  // hash -> anchor frame
+    std::vector<FingerprintHash> hashes;
+};
+
+#endif //COURSE_FINGERPRINTER_H
@@ -0,0 +1,266 @@
+#include "KeywordSpotter.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define COURSE_KWS_SSE 1
+#endif
+
+namespace {
+    const int REFRACTORY_WINDOWS = 100;  // one second of hops
+}
+
+KeywordSpotter::KeywordSpotter(int sampleRate, int channels)
+    : mfcc(sampleRate, channels), context(0), smooth(1), threshold(0.8f),
+      framesSeen(0), batchFill(0), posteriorIndex(0), refractory(0), detected(-1) {
+    mfcc.onFrame = [this](const float* coeffs) { onFeatures(coeffs); };
+}
+
+bool KeywordSpotter::load(const std::string& modelPath, std::string& error) {
+    std::ifstream file(modelPath);
+    if (!file.is_open()) {
+        error = "cannot open " + modelPath;
+        return false;
+    }
+
+    // Strip comments first so weights can be laid out freely
+    std::stringstream text;
+    std::string line;
+    while (std::getline(file, line)) {
+        text << line.substr(0, line.find('#')) << "\n";
+    }
+
+    labels.clear();
+    layers.clear();
+    context = 0;
+    smooth = 1;
+
+    std::string key;
+    while (text >> key) {
+        if (key == "labels") {
+            std::string list, name;
+            text >> list;
+            std::istringstream names(list);
+            while (std::getline(names, name, ',')) labels.push_back(name);
+        } else if (key == "context") {
+            text >> context;
+        } else if (key == "smooth") {
+            text >> smooth;
+        } else if (key == "dense") {
+            Layer layer;
+            std::string activation;
+            text >> layer.inputs >> layer.outputs >> activation;
+            if (!text || layer.inputs <= 0 || layer.outputs <= 0 || (activation != "relu" && activation != "linear")) {
+                error = modelPath + ": bad dense layer header";
+                return false;
+            }
+            layer.relu = activation == "relu";
+            layer.weights.resize(static_cast<size_t>(layer.inputs) * layer.outputs);
+            layer.bias.resize(layer.outputs);
+            for (float& w : layer.weights) text >> w;
+            for (float& b : layer.bias) text >> b;
+            if (!text) {
+                error = modelPath + ": layer " + std::to_string(layers.size()) + " is truncated";
+                return false;
+            }
+            layers.push_back(std::move(layer));
+        } else {
+            error = modelPath + ": unknown key " + key;
+            return false;
+        }
+    }
+
+    if (labels.size() < 2 || context <= 0 || smooth <= 0 || layers.empty()) {
+        error = modelPath + ": needs labels (at least two), context, smooth and layers";
+        return false;
+    }
+    if (layers.front().inputs != context * MfccExtractor::COEFFS) {
+        error = modelPath + ": first layer must take context * " + std::to_string(MfccExtractor::COEFFS) + " inputs";
+        return false;
+    }
+    if (layers.back().outputs != static_cast<int>(labels.size())) {
+        error = modelPath + ": last layer must have one output per label";
+        return false;
+    }
+    for (size_t i = 1; i < layers.size(); ++i) {
+        if (layers[i].inputs != layers[i - 1].outputs) {
+            error = modelPath + ": layer " + std::to_string(i) + " does not match the previous layer";
+            return false;
+        }
+    }
+
+    int widest = 0;
+    for (const Layer& layer : layers) {
+        widest = std::max({widest, layer.inputs, layer.outputs});
+    }
+    history.assign(static_cast<size_t>(context + BATCH - 1) * MfccExtractor::COEFFS, 0.0f);
+    bufferA.assign(static_cast<size_t>(widest) * BATCH, 0.0f);
+    bufferB.assign(static_cast<size_t>(widest) * BATCH, 0.0f);
+    posteriors.assign(static_cast<size_t>(smooth) * labels.size(), 0.0f);
+    sums.assign(labels.size(), 0.0f);
+    enabled.assign(labels.size(), true);
+    enabled[0] = false;
+    reset();
+    return true;
+}
+
+bool KeywordSpotter::setKeywords(const std::vector<std::string>& names, std::string& error) {
+    if (names.empty()) {
+        std::fill(enabled.begin(), enabled.end(), true);
+        if (!enabled.empty()) enabled[0] = false;
+        return true;
+    }
+
+    std::vector<bool> next(labels.size(), false);
+    for (const std::string& name : names) {
+        auto it = std::find(labels.begin(), labels.end(), name);
+        if (it == labels.end() || it == labels.begin()) {
+            error = "model has no keyword " + name;
+            return false;
+        }
+        next[it - labels.begin()] = true;
+    }
+    enabled = next;
+    return true;
+}
+
+void KeywordSpotter::setThreshold(float probability) {
+    threshold = probability;
+}
+
+void KeywordSpotter::reset() {
+    mfcc.reset();
+    std::fill(history.begin(), history.end(), 0.0f);
+    std::fill(posteriors.begin(), posteriors.end(), 0.0f);
+    std::fill(sums.begin(), sums.end(), 0.0f);
+    framesSeen = 0;
+    batchFill = 0;
+    posteriorIndex = 0;
+    refractory = 0;
+    detected = -1;
+}
+
+const std::vector<std::string>& KeywordSpotter::getLabels() const {
+    return labels;
+}
+
+int KeywordSpotter::getContextMs() const {
+    return context * 10;
+}
+
+size_t KeywordSpotter::getMemoryBytes() const {
+    size_t bytes = (history.size() + bufferA.size() + bufferB.size() + posteriors.size() + sums.size()) * sizeof(float);
+    for (const Layer& layer : layers) {
+        bytes += (layer.weights.size() + layer.bias.size()) * sizeof(float);
+    }
+    return bytes;
+}
+
+int KeywordSpotter::push(const short* samples, size_t count) {
+    if (layers.empty()) return -1;
+    detected = -1;
+    mfcc.push(samples, count);
+    return detected;
+}
+
+void KeywordSpotter::onFeatures(const float* coeffs) {
+    const size_t frameSize = MfccExtractor::COEFFS;
+    std::copy(history.begin() + frameSize, history.end(), history.begin());
+    std::copy(coeffs, coeffs + frameSize, history.end() - frameSize);
+    ++framesSeen;
+
+    if (++batchFill == BATCH) {
+        batchFill = 0;
+        evaluateBatch();
+    }
+}
+
+void KeywordSpotter::dense(const Layer& layer, const float* in, float* out) {
+    for (int o = 0; o < layer.outputs; ++o) {
+        const float* w = &layer.weights[static_cast<size_t>(o) * layer.inputs];
+#ifdef COURSE_KWS_SSE
+        __m128 acc0 = _mm_set1_ps(layer.bias[o]);
+        __m128 acc1 = acc0;
+        for (int i = 0; i < layer.inputs; ++i) {
+            __m128 weight = _mm_set1_ps(w[i]);
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(weight, _mm_loadu_ps(in + i * BATCH)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(weight, _mm_loadu_ps(in + i * BATCH + 4)));
+        }
+        if (layer.relu) {
+            acc0 = _mm_max_ps(acc0, _mm_setzero_ps());
+            acc1 = _mm_max_ps(acc1, _mm_setzero_ps());
+        }
+        _mm_storeu_ps(out + o * BATCH, acc0);
+        _mm_storeu_ps(out + o * BATCH + 4, acc1);
+#else
+        float acc[BATCH];
+        std::fill(acc, acc + BATCH, layer.bias[o]);
+        for (int i = 0; i < layer.inputs; ++i) {
+            for (int b = 0; b < BATCH; ++b) acc[b] += w[i] * in[i * BATCH + b];
+        }
+        for (int b = 0; b < BATCH; ++b) {
+            out[o * BATCH + b] = layer.relu ? std::max(acc[b], 0.0f) : acc[b];
+        }
+#endif
+    }
+}
+
+void KeywordSpotter::evaluateBatch() {
+    // Lane b is the window ending BATCH - 1 - b frames before the newest one
+    const size_t frameSize = MfccExtractor::COEFFS;
+    for (int b = 0; b < BATCH; ++b) {
+        const float* window = &history[b * frameSize];
+        for (size_t i = 0; i < static_cast<size_t>(context) * frameSize; ++i) {
+            bufferA[i * BATCH + b] = window[i];
+        }
+    }
+
+    float* in = bufferA.data();
+    float* out = bufferB.data();
+    for (const Layer& layer : layers) {
+        dense(layer, in, out);
+        std::swap(in, out);
+    }
+
+    const size_t classes = labels.size();
+    for (int b = 0; b < BATCH; ++b) {
+        // Windows that still reach back before the first frame are not scored
+        if (framesSeen < static_cast<size_t>(context + BATCH - 1 - b)) continue;
+
+        float peak = in[b];
+        for (size_t c = 1; c < classes; ++c) peak = std::max(peak, in[c * BATCH + b]);
+        float total = 0.0f;
+        float* slot = &posteriors[posteriorIndex * classes];
+        for (size_t c = 0; c < classes; ++c) {
+            float p = std::exp(in[c * BATCH + b] - peak);
+            total += p;
+            sums[c] -= slot[c];
+            slot[c] = p;
+        }
+        for (size_t c = 0; c < classes; ++c) {
+            slot[c] /= total;
+            sums[c] += slot[c];
+        }
+        posteriorIndex = (posteriorIndex + 1) % smooth;
+        if (posteriorIndex == 0) {
+            // Re-add from the ring once per lap so rounding cannot build up over hours
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            for (size_t i = 0; i < posteriors.size(); ++i) sums[i % classes] += posteriors[i];
+        }
+
+        if (refractory > 0) {
+            --refractory;
+            continue;
+        }
+        for (size_t c = 1; c < classes; ++c) {
+            if (enabled[c] && sums[c] / smooth > threshold) {
+                detected = static_cast<int>(c);
+                refractory = REFRACTORY_WINDOWS;
+                break;
+            }
+        }
+    }
+}
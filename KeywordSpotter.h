@@ -0,0 +1,83 @@
+#ifndef COURSE_KEYWORDSPOTTER_H
+#define COURSE_KEYWORDSPOTTER_H
+
+#include "MfccExtractor.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Keyword trigger: MFCC frames feed a small fully connected network that
+// scores a sliding window of `context` frames. Windows are evaluated
+// BATCH at a time (one per 10 ms hop, so every 80 ms), which lets every
+// weight be loaded once and applied to all lanes with one SIMD multiply.
+// Class posteriors are averaged over the last `smooth` windows; a keyword
+// fires when its average crosses the threshold and then stays quiet for a
+// refractory second. Memory is fixed once the model is loaded.
+//
+// Model files are text, '#' starts a comment:
+//
+//   labels filler,hey_course,record   first label is the non-keyword class
+//   context 100                       frames per window (10 ms each)
+//   smooth 30                         windows to average
+//   dense <in> <out> relu|linear      then out*in weights (row per output)
+//   ...                               and out biases
+//
+// The first layer takes context*13 inputs, oldest frame first; the last
+// layer has one output per label and is followed by a softmax.
+class KeywordSpotter {
+public:
+    static const int BATCH = 8;
+
+    KeywordSpotter(int sampleRate, int channels);
+
+    bool load(const std::string& modelPath, std::string& error);
+    // Keywords that fire; empty means every label except the first
+    bool setKeywords(const std::vector<std::string>& names, std::string& error);
+    void setThreshold(float probability);
+
+    // Returns the label index of a keyword completed in this block, or -1
+    int push(const short* samples, size_t count);
+    void reset();
+
+    const std::vector<std::string>& getLabels() const;
+    int getContextMs() const;
+    size_t getMemoryBytes() const;
+
+private:
+    struct Layer {
+        int inputs;
+        int outputs;
+        bool relu;
+        std::vector<float> weights;  // outputs x inputs
+        std::vector<float> bias;
+    };
+
+    void onFeatures(const float* coeffs);
+    void evaluateBatch();
+    static void dense(const Layer& layer, const float* in, float* out);
+
+    MfccExtractor mfcc;
+    std::vector<std::string> labels;
+    std::vector<bool> enabled;
+    std::vector<Layer> layers;
+    int context;
+    int smooth;
+    float threshold;
+
+    // Last context + BATCH - 1 feature frames, oldest first
+    std::vector<float> history;
+    size_t framesSeen;
+    int batchFill;
+
+    // Activations, feature-major: value i of lane b lives at [i * BATCH + b]
+    std::vector<float> bufferA;
+    std::vector<float> bufferB;
+
+    std::vector<float> posteriors;  // smooth x labels ring
+    std::vector<float> sums;
+    size_t posteriorIndex;
+    int refractory;
+    int detected;
+};
+
+#endif //COURSE_KEYWORDSPOTTER_H
@@ -0,0 +1,115 @@
+#include "MfccExtractor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double PI = 3.14159265358979323846;
+    const float PRE_EMPHASIS = 0.97f;
+    const float MEAN_RATE = 0.005f;  // about a 2 s time constant at 100 frames/s
+
+    size_t nextPowerOfTwo(size_t n) {
+        size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    double hzToMel(double hz) { return 2595.0 * std::log10(1.0 + hz / 700.0); }
+    double melToHz(double mel) { return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0); }
+}
+
+MfccExtractor::MfccExtractor(int sampleRate, int channels)
+    : channels(std::max(channels, 1)),
+      frameLength(static_cast<size_t>(sampleRate) * 25 / 1000),
+      hop(static_cast<size_t>(sampleRate) * 10 / 1000),
+      fft(nextPowerOfTwo(frameLength)),
+      window(frameLength), frame(frameLength), frameFill(0), spectrum(fft.size()),
+      melStart(MEL_BANDS), melWeights(MEL_BANDS), dct(COEFFS * MEL_BANDS),
+      melEnergy(MEL_BANDS), coeffs(COEFFS), runningMean(COEFFS), meanPrimed(false),
+      previous(0.0f), fold(0.0f), foldCount(0) {
+    for (size_t i = 0; i < frameLength; ++i) {
+        window[i] = static_cast<float>(0.54 - 0.46 * std::cos(2.0 * PI * i / (frameLength - 1)));
+    }
+
+    double binHz = static_cast<double>(sampleRate) / fft.size();
+    double low = hzToMel(20.0);
+    double high = hzToMel(std::min(8000.0, sampleRate / 2.0));
+    for (int m = 0; m < MEL_BANDS; ++m) {
+        double left = melToHz(low + (high - low) * m / (MEL_BANDS + 1));
+        double centre = melToHz(low + (high - low) * (m + 1) / (MEL_BANDS + 1));
+        double right = melToHz(low + (high - low) * (m + 2) / (MEL_BANDS + 1));
+
+        size_t first = static_cast<size_t>(std::ceil(left / binHz));
+        size_t last = std::min(static_cast<size_t>(right / binHz), fft.size() / 2);
+        melStart[m] = first;
+        for (size_t bin = first; bin <= last; ++bin) {
+            double hz = bin * binHz;
+            double weight = hz <= centre ? (hz - left) / (centre - left) : (right - hz) / (right - centre);
+            melWeights[m].push_back(static_cast<float>(std::max(0.0, weight)));
+        }
+    }
+
+    for (int c = 0; c < COEFFS; ++c) {
+        for (int m = 0; m < MEL_BANDS; ++m) {
+            dct[c * MEL_BANDS + m] = static_cast<float>(std::cos(PI * c * (m + 0.5) / MEL_BANDS));
+        }
+    }
+}
+
+void MfccExtractor::reset() {
+    frameFill = 0;
+    meanPrimed = false;
+    std::fill(runningMean.begin(), runningMean.end(), 0.0f);
+    previous = 0.0f;
+    fold = 0.0f;
+    foldCount = 0;
+}
+
+void MfccExtractor::push(const short* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        fold += samples[i];
+        if (++foldCount < channels) continue;
+
+        float sample = fold / (32768.0f * channels);
+        fold = 0.0f;
+        foldCount = 0;
+
+        frame[frameFill++] = sample - PRE_EMPHASIS * previous;
+        previous = sample;
+
+        if (frameFill == frameLength) {
+            analyseFrame();
+            // Keep the overlap for the next frame
+            std::copy(frame.begin() + hop, frame.end(), frame.begin());
+            frameFill = frameLength - hop;
+        }
+    }
+}
+
+void MfccExtractor::analyseFrame() {
+    for (size_t i = 0; i < frameLength; ++i) {
+        spectrum[i] = frame[i] * window[i];
+    }
+    std::fill(spectrum.begin() + frameLength, spectrum.end(), 0.0f);
+    fft.transform(spectrum);
+
+    for (int m = 0; m < MEL_BANDS; ++m) {
+        float energy = 0.0f;
+        for (size_t k = 0; k < melWeights[m].size(); ++k) {
+            energy += melWeights[m][k] * std::norm(spectrum[melStart[m] + k]);
+        }
+        melEnergy[m] = std::log(energy + 1e-10f);
+    }
+
+    for (int c = 0; c < COEFFS; ++c) {
+        float sum = 0.0f;
+        for (int m = 0; m < MEL_BANDS; ++m) {
+            sum += dct[c * MEL_BANDS + m] * melEnergy[m];
+        }
+        if (!meanPrimed) runningMean[c] = sum;
+        runningMean[c] += MEAN_RATE * (sum - runningMean[c]);
+        coeffs[c] = sum - runningMean[c];
+    }
+    meanPrimed = true;
+
+    if (onFrame) onFrame(coeffs.data());
+}
@@ -0,0 +1,56 @@
+#ifndef COURSE_MFCCEXTRACTOR_H
+#define COURSE_MFCCEXTRACTOR_H
+
+#include "Fft.h"
+#include <complex>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Streaming MFCC front end for keyword spotting: 25 ms Hamming frames every
+// 10 ms, pre-emphasis, 40 mel bands up to 8 kHz and the first 13 cepstral
+// coefficients. A slow running mean is subtracted from every coefficient so
+// microphone gain and room colouration do not shift the features. All
+// buffers are sized in the constructor.
+class MfccExtractor {
+public:
+    static const int COEFFS = 13;
+    static const int MEL_BANDS = 40;
+
+    MfccExtractor(int sampleRate, int channels);
+
+    // Calls onFrame with COEFFS values for every completed 10 ms hop
+    void push(const short* samples, size_t count);
+    void reset();
+
+    std::function<void(const float* coeffs)> onFrame;
+
+private:
+    void analyseFrame();
+
+    int channels;
+    size_t frameLength;
+    size_t hop;
+    Fft fft;
+
+    std::vector<float> window;
+    std::vector<float> frame;
+    size_t frameFill;
+    std::vector<std::complex<float>> spectrum;
+
+    // Triangular filters as (first bin, weights) pairs
+    std::vector<size_t> melStart;
+    std::vector<std::vector<float>> melWeights;
+    std::vector<float> dct;  // COEFFS x MEL_BANDS
+
+    std::vector<float> melEnergy;
+    std::vector<float> coeffs;
+    std::vector<float> runningMean;
+    bool meanPrimed;
+
+    float previous;
+    float fold;
+    int foldCount;
+};
+
+#endif //COURSE_MFCCEXTRACTOR_H
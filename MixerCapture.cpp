@@ -0,0 +1,95 @@
+#include "MixerCapture.h"
+#include <iostream>
+
+MixerCapture::MixerCapture(std::vector<std::string> inputNames, StreamMixer::Output output)
+    : inputNames(std::move(inputNames)), output(output), channels(0) {
+}
+
+MixerCapture::~MixerCapture() {
+    close();
+}
+
+bool MixerCapture::open(const CaptureFormat& format, int periodMs, BlockCallback callback) {
+    int inputs = static_cast<int>(inputNames.size());
+    int expected = output == StreamMixer::Output::Interleaved ? inputs : 1;
+    if (inputs == 0) {
+        std::cerr << "Mixer needs at least one input\n";
+        return false;
+    }
+    if (format.channels != expected) {
+        std::cerr << "Mixer produces " << expected << " channel(s), recorder is configured for "
+                  << format.channels << std::endl;
+        return false;
+    }
+
+    channels = format.channels;
+    this->callback = std::move(callback);
+    mixer = std::make_unique<StreamMixer>(inputs, format.sampleRate, output);
+
+    CaptureFormat inputFormat{format.sampleRate, 1, format.bitsPerSample};
+    for (int i = 0; i < inputs; ++i) {
+        auto child = createCaptureBackend(inputNames[i]);
+        if (!child) {
+            std::cerr << "Unknown capture backend: " << inputNames[i] << "\n";
+            close();
+            return false;
+        }
+        if (!child->open(inputFormat, periodMs, [this, i](const short* samples, size_t count) {
+                onInput(i, samples, count);
+            })) {
+            close();
+            return false;
+        }
+        child->setErrorCallback([this](const std::string& message) { reportError(message); });
+        children.push_back(std::move(child));
+    }
+    return true;
+}
+
+bool MixerCapture::start() {
+    for (auto& child : children) {
+        if (!child->start()) {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MixerCapture::stop() {
+    for (auto& child : children) {
+        child->stop();
+    }
+}
+
+void MixerCapture::close() {
+    for (auto& child : children) {
+        child->close();
+    }
+    children.clear();
+    mixer.reset();
+}
+
+uint64_t MixerCapture::getOverruns() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        total += children[i]->getOverruns();
+        if (mixer) total += mixer->getUnderruns(static_cast<int>(i)) + mixer->getOverruns(static_cast<int>(i));
+    }
+    return total;
+}
+
+const StreamMixer* MixerCapture::getMixer() const {
+    return mixer.get();
+}
+
+void MixerCapture::onInput(int index, const short* samples, size_t count) {
+    mixer->push(index, samples, count);
+    if (index != 0) return;
+
+    // The first input is the clock: mix whenever it delivers
+    size_t frames = mixer->mix(mixed, count * 2);
+    if (frames > 0 && callback) {
+        callback(mixed.data(), frames * channels);
+    }
+}
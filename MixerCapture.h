@@ -0,0 +1,41 @@
+#ifndef COURSE_MIXERCAPTURE_H
+#define COURSE_MIXERCAPTURE_H
+
+#include "CaptureBackend.h"
+#include "StreamMixer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Records several devices as one stream. Each child backend is opened mono,
+// the StreamMixer aligns them to the first child's clock, and the result is
+// delivered as one interleaved channel per device (or a mono downmix) from
+// the first child's capture thread. Since the recorder meters the peak over
+// all interleaved samples, the trigger follows the loudest microphone.
+class MixerCapture : public CaptureBackend {
+public:
+    MixerCapture(std::vector<std::string> inputNames, StreamMixer::Output output);
+    ~MixerCapture() override;
+
+    bool open(const CaptureFormat& format, int periodMs, BlockCallback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    const char* name() const override { return "mix"; }
+    uint64_t getOverruns() const override;
+
+    const StreamMixer* getMixer() const;
+
+private:
+    void onInput(int index, const short* samples, size_t count);
+
+    std::vector<std::string> inputNames;
+    StreamMixer::Output output;
+    std::vector<std::unique_ptr<CaptureBackend>> children;
+    std::unique_ptr<StreamMixer> mixer;
+    std::vector<short> mixed;
+    int channels;
+    BlockCallback callback;
+};
+
+#endif //COURSE_MIXERCAPTURE_H
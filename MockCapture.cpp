@@ -0,0 +1,109 @@
+#include "MockCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+MockCapture::~MockCapture() {
+    stop();
+}
+
+void MockCapture::setSource(std::vector<short> samples, bool loop) {
+    source = std::move(samples);
+    position = 0;
+    this->loop = loop;
+}
+
+void MockCapture::setJitter(int jitterUs, int lateEvery) {
+    this->jitterUs = jitterUs;
+    this->lateEvery = lateEvery;
+}
+
+bool MockCapture::open(const CaptureFormat& format, int periodMs, BlockCallback callback) {
+    this->format = format;
+    this->periodMs = std::max(1, periodMs);
+    this->callback = std::move(callback);
+    return true;
+}
+
+bool MockCapture::setWakeInterval(int ms) {
+    wakeMs = ms;
+    return true;
+}
+
+bool MockCapture::start() {
+    if (thread.joinable()) return false;
+    stopThread = false;
+    thread = std::thread(&MockCapture::captureThread, this);
+    return true;
+}
+
+void MockCapture::stop() {
+    stopThread = true;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void MockCapture::close() {
+    stop();
+    callback = nullptr;
+}
+
+void MockCapture::captureThread() {
+    using namespace std::chrono;
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> jitter(0, std::max(0, jitterUs));
+    std::vector<short> packet(static_cast<size_t>(format.sampleRate) * periodMs / 1000 * format.channels);
+
+    auto period = milliseconds(periodMs);
+    auto deadline = steady_clock::now();
+    long long packets = 0;
+
+    while (!stopThread) {
+        // A longer wake interval drains several periods per wakeup, like a device buffer
+        int batch = std::max(1, wakeMs.load() / periodMs);
+        if (batch > 1) {
+            deadline += period * batch;
+            std::this_thread::sleep_until(deadline + microseconds(jitter(rng)));
+            for (int i = 0; i < batch; ++i) {
+                deliverPacket(packet);
+            }
+            packets += batch;
+            continue;
+        }
+
+        deadline += period;
+
+        // A late wakeup leaves one period unserved, the next event then drains both packets
+        if (lateEvery > 0 && packets % lateEvery == lateEvery - 1) {
+            deadline += period;
+            std::this_thread::sleep_until(deadline + microseconds(jitter(rng)));
+            deliverPacket(packet);
+            deliverPacket(packet);
+            packets += 2;
+            continue;
+        }
+
+        std::this_thread::sleep_until(deadline + microseconds(jitter(rng)));
+        deliverPacket(packet);
+        ++packets;
+    }
+}
+
+void MockCapture::deliverPacket(std::vector<short>& packet) {
+    if (stopThread) return;
+
+    for (size_t i = 0; i < packet.size(); ++i) {
+        if (position >= source.size()) {
+            if (!loop || source.empty()) {
+                std::fill(packet.begin() + i, packet.end(), 0);
+                break;
+            }
+            position = 0;
+        }
+        packet[i] = source[position++];
+    }
+
+    if (callback) callback(packet.data(), packet.size());
+}
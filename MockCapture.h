@@ -0,0 +1,47 @@
+#ifndef COURSE_MOCKCAPTURE_H
+#define COURSE_MOCKCAPTURE_H
+
+#include "CaptureBackend.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Hardware-free backend with WASAPI-like timing: one packet per device period
+// delivered from an event-style thread, with wakeup jitter and an occasional
+// late wakeup that hands over two packets at once.
+class MockCapture : public CaptureBackend {
+public:
+    MockCapture() = default;
+    ~MockCapture() override;
+
+    // Interleaved samples in the format passed to open(); silence when empty
+    void setSource(std::vector<short> samples, bool loop = true);
+    void setJitter(int jitterUs, int lateEvery);
+
+    bool open(const CaptureFormat& format, int periodMs, BlockCallback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    const char* name() const override { return "mock"; }
+    bool setWakeInterval(int ms) override;
+
+private:
+    void captureThread();
+    void deliverPacket(std::vector<short>& packet);
+
+    CaptureFormat format{};
+    int periodMs = 10;
+    BlockCallback callback;
+
+    std::vector<short> source;
+    size_t position = 0;
+    bool loop = true;
+    int jitterUs = 500;
+    int lateEvery = 50;
+
+    std::thread thread;
+    std::atomic<bool> stopThread{false};
+    std::atomic<int> wakeMs{0};
+};
+
+#endif //COURSE_MOCKCAPTURE_H
@@ -0,0 +1,198 @@
+#include "QualityMeter.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace {
+    const double PI = 3.14159265358979323846;
+    const int PHASES = 4;             // true peak oversampling factor
+    const int TAPS = 12;              // per phase, 48 in total as BS.1770 Annex 2 suggests
+    const int DROPOUT_MS = 5;         // exact zeros this long are not a quiet room
+    const double ENERGY_FLOOR = 1e-10;  // -100 dB, keeps digital silence finite
+
+    double toLoudness(double energy) {
+        return -0.691 + 10.0 * std::log10(energy);
+    }
+}
+
+QualityMeter::QualityMeter(int sampleRate, int channels)
+    : channels(channels), state(channels),
+      blockFrames(std::max(1, sampleRate / 10)), dropoutFrames(sampleRate * DROPOUT_MS / 1000) {
+    // K-weighting for any sample rate: a high shelf modelling the head,
+    // then the RLB high-pass (coefficients as derived in libebur128)
+    double fs = sampleRate;
+    double k = std::tan(PI * 1681.974450955533 / fs);
+    double q = 0.7071752369554196;
+    double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    stages[0] = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    k = std::tan(PI * 38.13547087602444 / fs);
+    q = 0.5003270373238773;
+    a0 = 1.0 + k / q + k * k;
+    stages[1] = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    // Windowed sinc interpolator, each phase normalised to unity gain at DC
+    interpolator.resize(PHASES * TAPS);
+    double center = (PHASES * TAPS - 1) / 2.0;
+    for (int phase = 0; phase < PHASES; ++phase) {
+        double sum = 0.0;
+        for (int tap = 0; tap < TAPS; ++tap) {
+            int n = tap * PHASES + phase;
+            double x = (n - center) / PHASES;
+            double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+            double window = 0.5 - 0.5 * std::cos(2.0 * PI * (n + 0.5) / (PHASES * TAPS));
+            interpolator[phase * TAPS + tap] = sinc * window;
+            sum += sinc * window;
+        }
+        for (int tap = 0; tap < TAPS; ++tap) {
+            interpolator[phase * TAPS + tap] /= sum;
+        }
+    }
+
+    reset();
+}
+
+void QualityMeter::reset() {
+    for (ChannelState& channel : state) {
+        channel = ChannelState();
+        channel.history.assign(2 * TAPS, 0.0);
+    }
+    nextChannel = 0;
+    frameSilent = true;
+    blockFill = 0;
+    blockEnergy = 0.0;
+    energies.clear();
+    peak = 0.0;
+    clipped = 0;
+    dropouts = 0;
+    zeroRun = 0;
+    heardAudio = false;
+}
+
+double QualityMeter::weight(int channel, double sample) {
+    // Transposed direct form II, one pair of state variables per stage
+    ChannelState& s = state[channel];
+    double value = sample;
+    for (int i = 0; i < 2; ++i) {
+        const Biquad& f = stages[i];
+        double out = f.b0 * value + s.z1[i];
+        s.z1[i] = f.b1 * value - f.a1 * out + s.z2[i];
+        s.z2[i] = f.b2 * value - f.a2 * out;
+        value = out;
+    }
+    return value;
+}
+
+double QualityMeter::truePeak(int channel, double sample) {
+    // The history is stored twice so the newest TAPS samples are always contiguous
+    ChannelState& s = state[channel];
+    s.history[s.position] = sample;
+    s.history[s.position + TAPS] = sample;
+    const double* recent = &s.history[s.position + 1];
+    s.position = (s.position + 1) % TAPS;
+
+    double result = std::abs(sample);
+    for (int phase = 0; phase < PHASES; ++phase) {
+        const double* h = &interpolator[phase * TAPS];
+        double sum = 0.0;
+        for (int tap = 0; tap < TAPS; ++tap) {
+            sum += h[tap] * recent[TAPS - 1 - tap];
+        }
+        result = std::max(result, std::abs(sum));
+    }
+    return result;
+}
+
+void QualityMeter::push(const short* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        short raw = samples[i];
+        double sample = raw / 32768.0;
+        if (raw == 32767 || raw == -32768) ++clipped;
+        if (raw != 0) frameSilent = false;
+
+        // BS.1770 weights the surround channels of 5.1 higher; microphones all count the same
+        double weighted = weight(nextChannel, sample);
+        blockEnergy += weighted * weighted;
+        peak = std::max(peak, truePeak(nextChannel, sample));
+
+        if (++nextChannel < channels) continue;
+        nextChannel = 0;
+
+        if (frameSilent) {
+            ++zeroRun;
+        } else {
+            if (heardAudio && zeroRun >= dropoutFrames) ++dropouts;
+            zeroRun = 0;
+            heardAudio = true;
+        }
+        frameSilent = true;
+
+        if (++blockFill == blockFrames) {
+            energies.push_back(blockEnergy / blockFrames);
+            blockEnergy = 0.0;
+            blockFill = 0;
+        }
+    }
+}
+
+RecordingQuality QualityMeter::getQuality(uint64_t overruns) const {
+    RecordingQuality quality;
+    quality.clippedSamples = clipped;
+    quality.dropouts = dropouts;
+    quality.overruns = overruns;
+    quality.truePeakDbtp = peak > 0.0 ? 20.0 * std::log10(peak) : -std::numeric_limits<double>::infinity();
+
+    // Gating blocks are four consecutive 100 ms steps
+    std::vector<double> blocks;
+    for (size_t i = 3; i < energies.size(); ++i) {
+        blocks.push_back((energies[i - 3] + energies[i - 2] + energies[i - 1] + energies[i]) / 4.0);
+    }
+    double sum = 0.0;
+    size_t count = 0;
+    for (double energy : blocks) {
+        if (toLoudness(energy) > -70.0) {
+            sum += energy;
+            ++count;
+        }
+    }
+    quality.integratedLufs = -std::numeric_limits<double>::infinity();
+    if (count > 0) {
+        double relativeGate = toLoudness(sum / count) - 10.0;
+        sum = 0.0;
+        count = 0;
+        for (double energy : blocks) {
+            double loudness = toLoudness(energy);
+            if (loudness > -70.0 && loudness > relativeGate) {
+                sum += energy;
+                ++count;
+            }
+        }
+        quality.integratedLufs = toLoudness(sum / count);
+    }
+
+    if (!energies.empty()) {
+        std::vector<double> sorted = energies;
+        std::sort(sorted.begin(), sorted.end());
+        double noise = std::max(sorted[sorted.size() / 10], ENERGY_FLOOR);
+        double signal = std::max(sorted[sorted.size() * 9 / 10], ENERGY_FLOOR);
+        quality.snrDb = 10.0 * std::log10(signal / noise);
+    }
+    return quality;
+}
+
+std::string QualityMeter::describe(const RecordingQuality& quality) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "lufs=" << quality.integratedLufs
+        << " true_peak_dbtp=" << quality.truePeakDbtp
+        << " clipped=" << quality.clippedSamples
+        << " dropouts=" << quality.dropouts
+        << " overruns=" << quality.overruns
+        << " snr_db=" << quality.snrDb;
+    return out.str();
+}
@@ -0,0 +1,69 @@
+#ifndef COURSE_QUALITYMETER_H
+#define COURSE_QUALITYMETER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RecordingQuality {
+    double integratedLufs = 0.0;   // EBU R128 / BS.1770-4 gated loudness, -inf when all blocks are gated
+    double truePeakDbtp = 0.0;     // 4x oversampled peak, dB relative to full scale
+    uint64_t clippedSamples = 0;   // samples at either full-scale rail
+    uint32_t dropouts = 0;         // runs of digital silence inside the audio
+    uint64_t overruns = 0;         // overruns the capture backend reported while recording
+    double snrDb = 0.0;            // loud 100 ms blocks against quiet ones
+};
+
+// Measures a recording while it is written, so nothing has to decode the
+// file afterwards. Loudness follows BS.1770: K-weighting, 400 ms blocks in
+// 100 ms steps, absolute gate at -70 LUFS and relative gate 10 LU below.
+// The SNR estimate compares the 90th and 10th percentile of the 100 ms
+// block energies, which is meaningful as long as the clip has pauses.
+class QualityMeter {
+public:
+    QualityMeter(int sampleRate, int channels);
+
+    void push(const short* samples, size_t count);
+    // Backend overruns are counted by the caller, the rest is measured here
+    RecordingQuality getQuality(uint64_t overruns) const;
+    void reset();
+
+    // "lufs=-23.0 true_peak_dbtp=-1.2 clipped=0 dropouts=0 overruns=0 snr_db=35.1"
+    static std::string describe(const RecordingQuality& quality);
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+    struct ChannelState {
+        double z1[2] = {0.0, 0.0};
+        double z2[2] = {0.0, 0.0};
+        std::vector<double> history;  // last samples for the oversampling filter, stored twice
+        int position = 0;
+    };
+
+    double weight(int channel, double sample);
+    double truePeak(int channel, double sample);
+
+    int channels;
+    Biquad stages[2];
+    std::vector<double> interpolator;  // PHASES polyphase branches of TAPS each
+    std::vector<ChannelState> state;
+    int nextChannel;
+    bool frameSilent;
+
+    size_t blockFrames;
+    size_t blockFill;
+    double blockEnergy;
+    std::vector<double> energies;  // mean square per 100 ms block, summed over channels
+
+    double peak;
+    uint64_t clipped;
+    uint32_t dropouts;
+    size_t zeroRun;
+    size_t dropoutFrames;
+    bool heardAudio;
+};
+
+#endif //COURSE_QUALITYMETER_H
@@ -0,0 +1,235 @@
+#include "RecorderConfig.h"
+#include "ExportDestination.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+    struct IntField {
+        const char* key;
+        int RecorderConfig::* member;
+        int min;
+        int max;
+        bool restart;
+    };
+
+    const IntField INT_FIELDS[] = {
+        {"sample_rate", &RecorderConfig::sampleRate, 8000, 192000, true},
+        {"channels", &RecorderConfig::channels, 1, 32, true},
+        {"bits_per_sample", &RecorderConfig::bitsPerSample, 16, 16, true},
+        {"period_ms", &RecorderConfig::periodMs, 1, 500, true},
+        {"buffer_ms", &RecorderConfig::bufferMs, 10, 5000, false},
+        {"level_queue_size", &RecorderConfig::levelQueueSize, 1, 100000, false},
+        {"power_save_after_ms", &RecorderConfig::powerSaveAfterMs, 0, 24 * 3600 * 1000, false},
+        {"power_save_decimation", &RecorderConfig::powerSaveDecimation, 1, 64, false},
+        {"power_save_wake_ms", &RecorderConfig::powerSaveWakeMs, 10, 1000, false},
+        {"record_seconds", &RecorderConfig::recordSeconds, 1, 24 * 3600, false},
+        {"trim_lead_ms", &RecorderConfig::trimLeadMs, 0, 10000, false},
+        {"trim_tail_ms", &RecorderConfig::trimTailMs, 0, 10000, false},
+        {"split_pause_ms", &RecorderConfig::splitPauseMs, 0, 600000, false},
+        {"end_pause_ms", &RecorderConfig::endPauseMs, 0, 600000, false},
+        {"checkpoint_ms", &RecorderConfig::checkpointMs, 100, 60000, false},
+        {"dedup_window_s", &RecorderConfig::dedupWindowSeconds, 1, 365 * 24 * 3600, false},
+        {"export_batch_files", &RecorderConfig::exportBatchFiles, 1, 10000, false},
+        {"export_batch_ms", &RecorderConfig::exportBatchMs, 0, 24 * 3600 * 1000, false},
+        {"export_concurrency", &RecorderConfig::exportConcurrency, 1, 16, true},
+        {"export_kbps", &RecorderConfig::exportKbps, 0, 10000000, false},
+        {"export_retries", &RecorderConfig::exportRetries, 0, 100, false},
+        {"export_delete", &RecorderConfig::exportDelete, 0, 1, false},
+    };
+
+    std::string trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) return "";
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+}
+
+bool RecorderConfig::load(const std::string& path, RecorderConfig& config, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    // Parse into a copy so a broken file never leaves a half-applied config behind
+    RecorderConfig parsed = config;
+    if (!parsed.parse(text.str(), error)) {
+        error = path + ":" + error;
+        return false;
+    }
+    config = parsed;
+    return true;
+}
+
+bool RecorderConfig::parse(const std::string& text, std::string& error) {
+    std::istringstream in(text);
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            error = std::to_string(lineNumber) + ": expected key = value";
+            return false;
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+
+        if (key == "backend") {
+            backend = value;
+            continue;
+        }
+        if (key == "output_prefix") {
+            outputPrefix = value;
+            continue;
+        }
+        if (key == "journal") {
+            journal = value;
+            continue;
+        }
+        if (key == "recording_index") {
+            recordingIndex = value;
+            continue;
+        }
+        if (key == "fsync") {
+            if (value != "none" && value != "checkpoint" && value != "always") {
+                error = std::to_string(lineNumber) + ": fsync must be none, checkpoint or always";
+                return false;
+            }
+            fsync = value;
+            continue;
+        }
+        if (key == "dedup") {
+            if (value != "off" && value != "flag" && value != "drop") {
+                error = std::to_string(lineNumber) + ": dedup must be off, flag or drop";
+                return false;
+            }
+            dedup = value;
+            continue;
+        }
+        if (key == "dedup_index") {
+            dedupIndex = value;
+            continue;
+        }
+        if (key == "export") {
+            if (!value.empty() && !createExportDestination(value)) {
+                error = std::to_string(lineNumber) + ": export must be http://host[:port]/path or a directory";
+                return false;
+            }
+            exportTo = value;
+            continue;
+        }
+        if (key == "export_spool") {
+            exportSpool = value;
+            continue;
+        }
+        if (key == "trigger") {
+            if (value != "level" && value != "keyword") {
+                error = std::to_string(lineNumber) + ": trigger must be level or keyword";
+                return false;
+            }
+            trigger = value;
+            continue;
+        }
+        if (key == "kws_model") {
+            kwsModel = value;
+            continue;
+        }
+        if (key == "kws_keywords") {
+            kwsKeywords = value;
+            continue;
+        }
+        if (key == "kws_threshold") {
+            try {
+                size_t used = 0;
+                kwsThreshold = std::stod(value, &used);
+                if (used != value.size() || kwsThreshold <= 0.0 || kwsThreshold >= 1.0) throw std::invalid_argument(value);
+            } catch (const std::exception&) {
+                error = std::to_string(lineNumber) + ": kws_threshold must be a probability between 0 and 1";
+                return false;
+            }
+            continue;
+        }
+        if (key == "threshold") {
+            try {
+                size_t used = 0;
+                threshold = std::stod(value, &used);
+                if (used != value.size() || threshold < 0.0 || threshold > 100.0) throw std::invalid_argument(value);
+            } catch (const std::exception&) {
+                error = std::to_string(lineNumber) + ": threshold must be a percentage between 0 and 100";
+                return false;
+            }
+            continue;
+        }
+
+        bool known = false;
+        for (const IntField& field : INT_FIELDS) {
+            if (key != field.key) continue;
+            known = true;
+            try {
+                size_t used = 0;
+                int number = std::stoi(value, &used);
+                if (used != value.size() || number < field.min || number > field.max) throw std::invalid_argument(value);
+                this->*field.member = number;
+            } catch (const std::exception&) {
+                error = std::to_string(lineNumber) + ": " + key + " must be an integer in [" +
+                        std::to_string(field.min) + ", " + std::to_string(field.max) + "]";
+                return false;
+            }
+        }
+        if (!known) {
+            error = std::to_string(lineNumber) + ": unknown key " + key;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RecorderConfig::needsRestart(const RecorderConfig& other) const {
+    if (backend != other.backend) return true;
+    // The keyword model is loaded when capture starts
+    if (trigger != other.trigger || kwsModel != other.kwsModel || kwsKeywords != other.kwsKeywords) return true;
+    // So is the journal, together with the recovery pass
+    if (journal != other.journal) return true;
+    // And the exporter with its workers
+    if (exportTo != other.exportTo || exportSpool != other.exportSpool) return true;
+    for (const IntField& field : INT_FIELDS) {
+        if (field.restart && this->*field.member != other.*field.member) return true;
+    }
+    return false;
+}
+
+std::string RecorderConfig::diff(const RecorderConfig& other) const {
+    std::ostringstream out;
+    auto add = [&](const char* key, const auto& from, const auto& to) {
+        if (from == to) return;
+        if (out.tellp() > 0) out << ", ";
+        out << key << " " << from << " -> " << to;
+    };
+
+    add("backend", backend, other.backend);
+    add("threshold", threshold, other.threshold);
+    add("output_prefix", outputPrefix, other.outputPrefix);
+    add("trigger", trigger, other.trigger);
+    add("kws_model", kwsModel, other.kwsModel);
+    add("kws_keywords", kwsKeywords, other.kwsKeywords);
+    add("kws_threshold", kwsThreshold, other.kwsThreshold);
+    add("journal", journal, other.journal);
+    add("recording_index", recordingIndex, other.recordingIndex);
+    add("fsync", fsync, other.fsync);
+    add("dedup", dedup, other.dedup);
+    add("dedup_index", dedupIndex, other.dedupIndex);
+    add("export", exportTo, other.exportTo);
+    add("export_spool", exportSpool, other.exportSpool);
+    for (const IntField& field : INT_FIELDS) {
+        add(field.key, this->*field.member, other.*field.member);
+    }
+    return out.str();
+}
@@ -0,0 +1,84 @@
+#ifndef COURSE_RECORDERCONFIG_H
+#define COURSE_RECORDERCONFIG_H
+
+#include <string>
+
+// Every recorder tunable in one place. Files use one "key = value" per line,
+// '#' starts a comment and unknown keys are errors. Capture settings (backend,
+// format, period) need the device reopened and only apply on the next start;
+// everything else is hot and is picked up at the next block boundary.
+struct RecorderConfig {
+    // Capture
+    std::string backend;
+    int sampleRate = 44100;
+    int channels = 2;
+    int bitsPerSample = 16;
+    int periodMs = 10;
+
+    // Metering and trigger
+    int bufferMs = 250;
+    double threshold = 10.0;
+    int levelQueueSize = 100;
+
+    // "level" starts on loudness; "keyword" starts when the spotter hears one
+    // of kwsKeywords (comma separated, empty means all). Either way the
+    // recording stops after endPauseMs of quiet (see Recording below)
+    std::string trigger = "level";
+    std::string kwsModel;
+    std::string kwsKeywords;
+    double kwsThreshold = 0.8;
+
+    // Power saving: after powerSaveAfterMs of quiet (0 disables) metering
+    // only looks at every powerSaveDecimation-th frame, the keyword spotter
+    // pauses and the backend wakes every powerSaveWakeMs. A packet above half
+    // the threshold restores full analysis before its block is judged.
+    int powerSaveAfterMs = 0;
+    int powerSaveDecimation = 4;
+    int powerSaveWakeMs = 200;
+
+    // Recording
+    int recordSeconds = 5;
+    std::string outputPrefix = "output_";
+    int trimLeadMs = 100;
+    int trimTailMs = 200;
+    // Pauses longer than splitPauseMs split a recording into _N segments; a
+    // pause longer than endPauseMs ends it (0: the first quiet block), so
+    // splits need endPauseMs above splitPauseMs
+    int splitPauseMs = 700;
+    int endPauseMs = 2000;
+
+    // Crash safety: sessions are listed in the journal ("" disables it and
+    // recovery), headers are checkpointed every checkpointMs and fsync is
+    // "none", "checkpoint" or "always" (after every written batch)
+    std::string journal = "recordings.journal";
+    // One line per saved recording with its capture-clock timestamps ("" disables)
+    std::string recordingIndex = "recordings.index";
+    std::string fsync = "checkpoint";
+    int checkpointMs = 1000;
+
+    // Duplicate clips: "off", "flag" (keep and report) or "drop" (delete the file)
+    std::string dedup = "off";
+    int dedupWindowSeconds = 3600;
+    std::string dedupIndex = "fingerprints";
+
+    // Shipping of saved recordings ("" disables): "http://host:port/path" or
+    // a directory. Files are tarred in batches in exportSpool; exportKbps 0
+    // is unlimited and exportDelete removes originals once they are spooled.
+    std::string exportTo;
+    std::string exportSpool = "export_spool";
+    int exportBatchFiles = 10;
+    int exportBatchMs = 60000;
+    int exportConcurrency = 2;
+    int exportKbps = 0;
+    int exportRetries = 5;
+    int exportDelete = 0;
+
+    static bool load(const std::string& path, RecorderConfig& config, std::string& error);
+    bool parse(const std::string& text, std::string& error);
+
+    bool needsRestart(const RecorderConfig& other) const;
+    // "threshold 10 -> 20, buffer_ms 250 -> 100"; empty when nothing differs
+    std::string diff(const RecorderConfig& other) const;
+};
+
+#endif //COURSE_RECORDERCONFIG_H
@@ -0,0 +1,82 @@
+#ifndef COURSE_RECORDERMETRICS_H
+#define COURSE_RECORDERMETRICS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Counters updated by the capture and recording threads. Everything is a
+// relaxed atomic so readers (control socket, GUI) never block the audio path.
+struct RecorderMetrics {
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> framesCaptured{0};
+    std::atomic<uint64_t> meterBlocks{0};
+    std::atomic<uint64_t> levelQueueDrops{0};
+    std::atomic<uint64_t> recordingsSaved{0};
+    std::atomic<uint64_t> duplicatesFound{0};
+    std::atomic<uint64_t> keywordDetections{0};
+    std::atomic<uint64_t> recordingsRecovered{0};
+
+    // Export: delivered batches and bytes, failed attempts, batches waiting in the spool
+    std::atomic<uint64_t> exportBatchesSent{0};
+    std::atomic<uint64_t> exportBytesSent{0};
+    std::atomic<uint64_t> exportFailures{0};
+    std::atomic<uint32_t> exportBacklog{0};
+
+    // Power saving: how often it was entered and for how long in total
+    std::atomic<uint64_t> powerSaveEntries{0};
+    std::atomic<uint64_t> powerSaveMs{0};
+
+    // Whole-process cost over the last sampling interval, scaled to one hour
+    std::atomic<uint64_t> cpuMsPerHour{0};
+    std::atomic<uint64_t> wakeupsPerHour{0};
+
+    // Bumped on every applied configuration change, with its wall-clock time in ms
+    std::atomic<uint64_t> configGeneration{0};
+    std::atomic<int64_t> configAppliedUnixMs{0};
+
+    // Time spent in the capture callback per packet
+    std::atomic<uint32_t> processUsLast{0};
+    std::atomic<uint32_t> processUsMax{0};
+
+    // Time from a block being captured to it being written to disk
+    std::atomic<uint32_t> writeLatencyMsLast{0};
+    std::atomic<uint32_t> writeLatencyMsMax{0};
+
+    // Capture clock against steady_clock: estimated device rate, drift from
+    // the nominal rate in parts per billion and packet delivery jitter
+    std::atomic<uint64_t> deviceRateMilliHz{0};
+    std::atomic<int64_t> clockDriftPpb{0};
+    std::atomic<uint32_t> clockJitterUs{0};
+
+    // Header checkpoint including fsync, if the policy asks for one
+    std::atomic<uint32_t> checkpointUsLast{0};
+    std::atomic<uint32_t> checkpointUsMax{0};
+
+    // Fingerprint index lookup per finished clip
+    std::atomic<uint32_t> dedupLookupUsLast{0};
+    std::atomic<uint32_t> dedupLookupUsMax{0};
+
+    static void updateMax(std::atomic<uint32_t>& max, uint32_t value) {
+        uint32_t current = max.load(std::memory_order_relaxed);
+        while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+};
+
+// One entry of the binary level stream, sent per capture packet (little endian, 16 bytes)
+struct LevelFrame {
+    uint32_t sequence;
+    float level;      // packet peak, percent of full scale
+    uint32_t frames;  // frames in the packet
+    uint16_t flags;   // LevelFrameFlags
+    uint16_t reserved;
+};
+
+enum LevelFrameFlags : uint16_t {
+    LEVEL_FLAG_RECORDING = 1,
+    LEVEL_FLAG_ARMED = 2,
+};
+
+static_assert(sizeof(LevelFrame) == 16, "LevelFrame is part of the wire protocol");
+
+#endif //COURSE_RECORDERMETRICS_H
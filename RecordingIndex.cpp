@@ -0,0 +1,54 @@
+#include "RecordingIndex.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+RecordingIndex::~RecordingIndex() {
+    close();
+}
+
+bool RecordingIndex::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        std::cerr << "Cannot open recording index " << path << "\n";
+        return false;
+    }
+    this->path = path;
+    return true;
+}
+
+void RecordingIndex::close() {
+    if (!file) return;
+    std::fclose(file);
+    file = nullptr;
+    path.clear();
+}
+
+const std::string& RecordingIndex::getPath() const {
+    return path;
+}
+
+std::string RecordingIndex::describe(const RecordingEntry& entry) {
+    std::ostringstream out;
+    double drift = entry.nominalRate > 0 ? (entry.start.rate / entry.nominalRate - 1.0) * 1e6 : 0.0;
+    out << "start_frame=" << entry.start.frame
+        << " frames=" << entry.frames
+        << " start_unix_ns=" << entry.start.unixNs
+        << " start_monotonic_ns=" << entry.start.monotonicNs
+        << std::fixed << std::setprecision(3)
+        << " rate_hz=" << entry.start.rate
+        << " drift_ppm=" << drift;
+    return out.str();
+}
+
+std::string RecordingIndex::formatLine(const RecordingEntry& entry) {
+    return "file=" + entry.file + " " + describe(entry) + " " + QualityMeter::describe(entry.quality) + "\n";
+}
+
+void RecordingIndex::append(const RecordingEntry& entry) {
+    if (!file) return;
+    std::string line = formatLine(entry);
+    std::fwrite(line.data(), 1, line.size(), file);
+    std::fflush(file);
+}
@@ -0,0 +1,45 @@
+#ifndef COURSE_RECORDINGINDEX_H
+#define COURSE_RECORDINGINDEX_H
+
+#include "CaptureClock.h"
+#include "QualityMeter.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+struct RecordingEntry {
+    std::string file;
+    BlockStamp start;       // first frame of the file
+    uint64_t frames = 0;
+    int nominalRate = 0;
+    RecordingQuality quality;
+};
+
+// Append-only event index, one line of key=value pairs per saved recording,
+// so clips can be lined up with other logs or filtered on loudness and
+// quality without opening the WAV files.
+class RecordingIndex {
+public:
+    RecordingIndex() = default;
+    ~RecordingIndex();
+
+    RecordingIndex(const RecordingIndex&) = delete;
+    RecordingIndex& operator=(const RecordingIndex&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    const std::string& getPath() const;
+
+    void append(const RecordingEntry& entry);
+    // The full index line, newline included
+    static std::string formatLine(const RecordingEntry& entry);
+    // The timing key=value pairs without the file name, for WAV metadata;
+    // the quality pairs come from QualityMeter::describe()
+    static std::string describe(const RecordingEntry& entry);
+
+private:
+    std::FILE* file = nullptr;
+    std::string path;
+};
+
+#endif //COURSE_RECORDINGINDEX_H
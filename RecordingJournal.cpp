@@ -0,0 +1,87 @@
+#include "RecordingJournal.h"
+#include "WavWriter.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+RecordingJournal::~RecordingJournal() {
+    close();
+}
+
+int RecordingJournal::open(const std::string& path, bool sync) {
+    close();
+
+    std::vector<std::string> pending;
+    std::ifstream previous(path);
+    std::string line;
+    while (std::getline(previous, line)) {
+        if (line.size() < 6) continue;
+        std::string filename = line.substr(5);
+        if (line.compare(0, 5, "open ") == 0) {
+            pending.push_back(filename);
+        } else if (line.compare(0, 5, "done ") == 0) {
+            pending.erase(std::remove(pending.begin(), pending.end(), filename), pending.end());
+        }
+    }
+    previous.close();
+
+    int repaired = 0;
+    for (const std::string& filename : pending) {
+        uint32_t dataSize = 0;
+        if (WavWriter::repair(filename, dataSize)) {
+            std::cout << "Recovered " << filename << " (" << dataSize << " bytes of audio)\n";
+            ++repaired;
+        } else {
+            std::cerr << "Could not recover " << filename << "\n";
+        }
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Cannot open recording journal " << path << "\n";
+        return -1;
+    }
+    this->path = path;
+    this->sync = sync;
+    openSessions = 0;
+    return repaired;
+}
+
+void RecordingJournal::close() {
+    if (!file) return;
+    std::fclose(file);
+    file = nullptr;
+    path.clear();
+}
+
+bool RecordingJournal::isOpen() const {
+    return file != nullptr;
+}
+
+void RecordingJournal::begin(const std::string& filename) {
+    if (!file) return;
+    ++openSessions;
+    append("open", filename);
+}
+
+void RecordingJournal::end(const std::string& filename) {
+    if (!file) return;
+    append("done", filename);
+
+    if (--openSessions <= 0) {
+        openSessions = 0;
+        std::FILE* emptied = std::freopen(path.c_str(), "wb", file);
+        file = emptied;
+    }
+}
+
+void RecordingJournal::append(const char* action, const std::string& filename) {
+    std::fprintf(file, "%s %s\n", action, filename.c_str());
+    // The open entry has to be on disk before any audio that depends on it
+    if (sync) {
+        WavWriter::syncFile(file);
+    } else {
+        std::fflush(file);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef COURSE_RECORDINGJOURNAL_H
+#define COURSE_RECORDINGJOURNAL_H
+
+#include <cstdio>
+#include <string>
+
+// Append-only list of recording sessions: "open <file>" when a WAV is
+// created, "done <file>" once its header is final. The journal is emptied
+// whenever no session is open, so it only ever holds the sessions that were
+// in flight and recovery never has to look at the archive itself.
+class RecordingJournal {
+public:
+    RecordingJournal() = default;
+    ~RecordingJournal();
+
+    RecordingJournal(const RecordingJournal&) = delete;
+    RecordingJournal& operator=(const RecordingJournal&) = delete;
+
+    // Repairs the files of sessions a previous run left open, then starts a fresh journal.
+    // Returns the number of repaired recordings, or -1 when the journal cannot be opened.
+    int open(const std::string& path, bool sync);
+    void close();
+    bool isOpen() const;
+
+    void begin(const std::string& filename);
+    void end(const std::string& filename);
+
+private:
+    void append(const char* action, const std::string& filename);
+
+    std::FILE* file = nullptr;
+    std::string path;
+    bool sync = false;
+    int openSessions = 0;
+};
+
+#endif //COURSE_RECORDINGJOURNAL_H
@@ -0,0 +1,111 @@
+#include "SilenceSplitter.h"
+#include <algorithm>
+#include <cstdlib>
+
+SilenceSplitter::SilenceSplitter(int sampleRate, int channels, double threshold,
+                                 int leadMs, int tailMs, int splitPauseMs, int frameMs)
+    : threshold(threshold) {
+    auto toSamples = [&](int ms) {
+        return static_cast<size_t>(sampleRate) * ms / 1000 * channels;
+    };
+    frameSamples = std::max<size_t>(channels, toSamples(frameMs));
+    leadSamples = toSamples(leadMs);
+    tailSamples = toSamples(tailMs);
+    splitSamples = std::max(tailSamples, toSamples(splitPauseMs));
+    frame.reserve(frameSamples);
+}
+
+void SilenceSplitter::push(const short* data, size_t samples) {
+    while (samples > 0) {
+        size_t n = std::min(samples, frameSamples - frame.size());
+        frame.insert(frame.end(), data, data + n);
+        data += n;
+        samples -= n;
+
+        if (frame.size() == frameSamples) {
+            processFrame(frame.data(), frame.size());
+            processed += frame.size();
+            frame.clear();
+        }
+    }
+}
+
+void SilenceSplitter::finish() {
+    if (!frame.empty()) {
+        processFrame(frame.data(), frame.size());
+        processed += frame.size();
+        frame.clear();
+    }
+    if (inSegment) {
+        endSegment();
+    }
+    preRoll.clear();
+    pendingSilence.clear();
+}
+
+size_t SilenceSplitter::getSegmentStart() const {
+    return segmentStart;
+}
+
+void SilenceSplitter::processFrame(const short* data, size_t samples) {
+    int peak = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        peak = std::max(peak, std::abs((int)data[i]));
+    }
+    double level = std::min(100.0, (peak / 32767.0) * 100.0);
+    bool loud = level > threshold;
+
+    if (!inSegment) {
+        if (loud) {
+            segmentStart = processed - preRoll.size();
+            beginSegment();
+            emit(data, samples);
+        } else {
+            preRoll.insert(preRoll.end(), data, data + samples);
+            if (preRoll.size() > leadSamples) {
+                preRoll.erase(preRoll.begin(), preRoll.end() - leadSamples);
+            }
+        }
+        return;
+    }
+
+    if (loud) {
+        // The pause was short enough to stay in the same segment
+        emit(pendingSilence.data(), pendingSilence.size());
+        pendingSilence.clear();
+        emit(data, samples);
+        return;
+    }
+
+    pendingSilence.insert(pendingSilence.end(), data, data + samples);
+    if (pendingSilence.size() >= splitSamples) {
+        endSegment();
+    }
+}
+
+void SilenceSplitter::beginSegment() {
+    inSegment = true;
+    if (onSegmentStart) onSegmentStart(segmentIndex);
+
+    std::vector<short> lead(preRoll.begin(), preRoll.end());
+    emit(lead.data(), lead.size());
+    preRoll.clear();
+}
+
+void SilenceSplitter::endSegment() {
+    size_t tail = std::min(tailSamples, pendingSilence.size());
+    emit(pendingSilence.data(), tail);
+    if (onSegmentEnd) onSegmentEnd(segmentIndex);
+
+    // Whatever silence was not kept as tail can still serve as lead-in for the next segment
+    size_t keep = std::min(leadSamples, pendingSilence.size() - tail);
+    preRoll.assign(pendingSilence.end() - keep, pendingSilence.end());
+    pendingSilence.clear();
+
+    inSegment = false;
+    ++segmentIndex;
+}
+
+void SilenceSplitter::emit(const short* data, size_t samples) {
+    if (samples > 0 && onSegmentData) onSegmentData(data, samples);
+}
@@ -0,0 +1,49 @@
+#ifndef COURSE_SILENCESPLITTER_H
+#define COURSE_SILENCESPLITTER_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Streaming silence trimmer. Blocks are pushed in as they are captured and
+// forwarded to the segment callbacks with leading/trailing silence cut down to
+// the configured margins. A pause longer than splitPauseMs closes the current
+// segment; the next loud frame opens a new one.
+class SilenceSplitter {
+public:
+    SilenceSplitter(int sampleRate, int channels, double threshold,
+                    int leadMs = 100, int tailMs = 200, int splitPauseMs = 700, int frameMs = 10);
+
+    void push(const short* data, size_t samples);
+    void finish();
+
+    // Position of the current segment's first sample in everything pushed so far
+    size_t getSegmentStart() const;
+
+    std::function<void(int index)> onSegmentStart;
+    std::function<void(const short* data, size_t samples)> onSegmentData;
+    std::function<void(int index)> onSegmentEnd;
+
+private:
+    void processFrame(const short* frame, size_t samples);
+    void beginSegment();
+    void endSegment();
+    void emit(const short* data, size_t samples);
+
+    double threshold;
+    size_t frameSamples;
+    size_t leadSamples;
+    size_t tailSamples;
+    size_t splitSamples;
+
+    std::vector<short> frame;
+    std::deque<short> preRoll;
+    std::vector<short> pendingSilence;
+    bool inSegment = false;
+    int segmentIndex = 0;
+    size_t processed = 0;
+    size_t segmentStart = 0;
+};
+
+#endif //COURSE_SILENCESPLITTER_H
@@ -0,0 +1,216 @@
+#include "StreamMixer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Steering gains per mix() call, error measured in frames
+    const double DRIFT_KP = 1e-5;
+    const double DRIFT_KI = 2e-8;
+    const double MAX_DRIFT = 2e-3;
+    // FIFO capacity beyond the latency margin, in packets of the largest size seen
+    const size_t FIFO_PACKETS = 4;
+    // Frames the interpolator reads around its position
+    const size_t LOOK_AHEAD = 3;
+
+    inline float hermite(float y0, float y1, float y2, float y3, float f) {
+        float c1 = 0.5f * (y2 - y0);
+        float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+        return ((c3 * f + c2) * f + c1) * f + y1;
+    }
+
+    inline short toSample(float value) {
+        return static_cast<short>(std::lrint(std::clamp(value * 32767.0f, -32768.0f, 32767.0f)));
+    }
+}
+
+StreamMixer::StreamMixer(int inputs, int sampleRate, Output output, int latencyMs)
+    : inputCount(std::max(1, inputs)), sampleRate(sampleRate), output(output),
+      latencyFrames(static_cast<size_t>(sampleRate) * latencyMs / 1000), aligned(false), largestPacket(0), loudest(0) {
+    for (int i = 0; i < inputCount; ++i) {
+        this->inputs.push_back(std::make_unique<Input>());
+    }
+    scratch.resize(inputCount);
+}
+
+void StreamMixer::push(int index, const short* samples, size_t frames, int channels) {
+    if (index < 0 || index >= inputCount || channels < 1) return;
+
+    Input& input = *inputs[index];
+    std::lock_guard<std::mutex> lock(input.mutex);
+    input.fifo.reserve(input.fifo.size() + frames);
+
+    const float scale = 1.0f / (32768.0f * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        int sum = 0;
+        for (int c = 0; c < channels; ++c) {
+            sum += samples[i * channels + c];
+        }
+        input.fifo.push_back(sum * scale);
+    }
+    input.started = true;
+
+    // Nothing consumes this input while the master stalls. Dropping back to
+    // the latency margin, where the master's fill sits, leaves nothing for
+    // the steering to catch up on once it resumes.
+    size_t largest = largestPacket.load(std::memory_order_relaxed);
+    while (frames > largest && !largestPacket.compare_exchange_weak(largest, frames, std::memory_order_relaxed)) {
+    }
+    size_t capacity = latencyFrames + FIFO_PACKETS * std::max(largest, frames) + LOOK_AHEAD;
+    if (available(input) > capacity) {
+        input.readOffset += available(input) - latencyFrames;
+        input.overruns.fetch_add(1, std::memory_order_relaxed);
+        compact(input);
+    }
+}
+
+size_t StreamMixer::available(Input& input) const {
+    return input.fifo.size() - input.readOffset;
+}
+
+void StreamMixer::compact(Input& input) {
+    // Keep one sample of history for the interpolator
+    if (input.readOffset > 4096 && input.readOffset * 2 > input.fifo.size()) {
+        size_t drop = input.readOffset - 1;
+        input.fifo.erase(input.fifo.begin(), input.fifo.begin() + drop);
+        input.readOffset -= drop;
+    }
+}
+
+void StreamMixer::steer(Input& input, double masterFill) {
+    double error = (available(input) - input.fraction) - masterFill;
+    input.smoothedError += 0.01 * (error - input.smoothedError);
+    input.errorIntegral = std::clamp(input.errorIntegral + input.smoothedError,
+                                     -MAX_DRIFT / DRIFT_KI, MAX_DRIFT / DRIFT_KI);
+    input.ratio = 1.0 + std::clamp(DRIFT_KP * input.smoothedError + DRIFT_KI * input.errorIntegral,
+                                   -MAX_DRIFT, MAX_DRIFT);
+    input.driftPpm.store((input.ratio - 1.0) * 1e6, std::memory_order_relaxed);
+}
+
+size_t StreamMixer::mix(std::vector<short>& out, size_t maxFrames) {
+    if (!aligned) {
+        // Start once every stream is running, trimming all of them to the same fill
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (auto& input : inputs) {
+            locks.emplace_back(input->mutex);
+            if (!input->started || available(*input) < latencyFrames) return 0;
+        }
+        for (auto& input : inputs) {
+            input->readOffset += available(*input) - latencyFrames;
+            compact(*input);
+        }
+        aligned = true;
+    }
+
+    // The master clock decides how much can be produced; keep the latency margin buffered
+    Input& master = *inputs[0];
+    size_t frames;
+    double masterFill;
+    {
+        std::lock_guard<std::mutex> lock(master.mutex);
+        size_t masterAvailable = available(master);
+        frames = masterAvailable > latencyFrames ? std::min(maxFrames, masterAvailable - latencyFrames) : 0;
+        if (frames == 0) return 0;
+
+        scratch[0].assign(master.fifo.begin() + master.readOffset,
+                          master.fifo.begin() + master.readOffset + frames);
+        master.readOffset += frames;
+        masterFill = static_cast<double>(available(master));
+        compact(master);
+    }
+
+    for (int i = 1; i < inputCount; ++i) {
+        Input& input = *inputs[i];
+        std::vector<float>& dst = scratch[i];
+        dst.assign(frames, 0.0f);
+
+        std::lock_guard<std::mutex> lock(input.mutex);
+        const float* src = input.fifo.data();
+        size_t size = input.fifo.size();
+        double pos = input.fraction;
+        size_t k = 0;
+        for (; k < frames; ++k) {
+            size_t j = input.readOffset + static_cast<size_t>(pos);
+            if (j + 2 >= size) break;
+            float f = static_cast<float>(pos - std::floor(pos));
+            float y0 = src[j > 0 ? j - 1 : 0];
+            dst[k] = hermite(y0, src[j], src[j + 1], src[j + 2], f);
+            pos += input.ratio;
+        }
+        if (k < frames) {
+            input.underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        size_t consumed = static_cast<size_t>(pos);
+        input.readOffset = std::min(size, input.readOffset + consumed);
+        input.fraction = pos - consumed;
+        steer(input, masterFill);
+        compact(input);
+    }
+
+    int outChannels = getOutputChannels();
+    out.resize(frames * outChannels);
+
+    int loudestIndex = 0;
+    float loudestPeak = -1.0f;
+    for (int i = 0; i < inputCount; ++i) {
+        float peak = 0.0f;
+        for (float value : scratch[i]) {
+            peak = std::max(peak, std::fabs(value));
+        }
+        inputs[i]->level.store(std::min(100.0, peak * 100.0), std::memory_order_relaxed);
+        if (peak > loudestPeak) {
+            loudestPeak = peak;
+            loudestIndex = i;
+        }
+    }
+    loudest.store(loudestIndex, std::memory_order_relaxed);
+
+    if (output == Output::Interleaved) {
+        for (int i = 0; i < inputCount; ++i) {
+            const float* src = scratch[i].data();
+            short* dst = out.data() + i;
+            for (size_t k = 0; k < frames; ++k) {
+                dst[k * inputCount] = toSample(src[k]);
+            }
+        }
+    } else {
+        const float gain = 1.0f / inputCount;
+        for (size_t k = 0; k < frames; ++k) {
+            float sum = 0.0f;
+            for (int i = 0; i < inputCount; ++i) {
+                sum += scratch[i][k];
+            }
+            out[k] = toSample(sum * gain);
+        }
+    }
+    return frames;
+}
+
+int StreamMixer::getInputs() const {
+    return inputCount;
+}
+
+int StreamMixer::getOutputChannels() const {
+    return output == Output::Interleaved ? inputCount : 1;
+}
+
+int StreamMixer::getLoudestInput() const {
+    return loudest.load(std::memory_order_relaxed);
+}
+
+double StreamMixer::getLevel(int input) const {
+    return inputs[input]->level.load(std::memory_order_relaxed);
+}
+
+double StreamMixer::getDriftPpm(int input) const {
+    return inputs[input]->driftPpm.load(std::memory_order_relaxed);
+}
+
+uint64_t StreamMixer::getUnderruns(int input) const {
+    return inputs[input]->underruns.load(std::memory_order_relaxed);
+}
+
+uint64_t StreamMixer::getOverruns(int input) const {
+    return inputs[input]->overruns.load(std::memory_order_relaxed);
+}
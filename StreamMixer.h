@@ -0,0 +1,67 @@
+#ifndef COURSE_STREAMMIXER_H
+#define COURSE_STREAMMIXER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Aligns several mono capture streams to the sample clock of input 0.
+// Every other input is read through a cubic fractional resampler whose ratio
+// is steered so its FIFO fill tracks the master's, which cancels the clock
+// drift between devices. Output is either one interleaved channel per input
+// or a mono downmix. An input that runs ahead of the master, e.g. because the
+// master stalled, is capped at a few packets and loses its oldest frames.
+class StreamMixer {
+public:
+    enum class Output { Interleaved, Downmix };
+
+    StreamMixer(int inputs, int sampleRate, Output output = Output::Interleaved, int latencyMs = 40);
+
+    // Thread-safe, one producer per input. Multichannel packets are folded to mono.
+    void push(int input, const short* samples, size_t frames, int channels = 1);
+
+    // Produces up to maxFrames aligned frames, returns how many were written to out
+    size_t mix(std::vector<short>& out, size_t maxFrames);
+
+    int getInputs() const;
+    int getOutputChannels() const;
+    int getLoudestInput() const;
+    double getLevel(int input) const;
+    double getDriftPpm(int input) const;
+    uint64_t getUnderruns(int input) const;
+    uint64_t getOverruns(int input) const;
+
+private:
+    struct Input {
+        std::mutex mutex;
+        std::vector<float> fifo;
+        size_t readOffset = 0;
+        double fraction = 0.0;
+        double ratio = 1.0;
+        double errorIntegral = 0.0;
+        double smoothedError = 0.0;
+        bool started = false;
+        std::atomic<double> level{0.0};
+        std::atomic<double> driftPpm{0.0};
+        std::atomic<uint64_t> underruns{0};
+        std::atomic<uint64_t> overruns{0};
+    };
+
+    size_t available(Input& input) const;
+    void compact(Input& input);
+    void steer(Input& input, double masterFill);
+
+    int inputCount;
+    int sampleRate;
+    Output output;
+    size_t latencyFrames;
+    bool aligned;
+    std::atomic<size_t> largestPacket;
+    std::atomic<int> loudest;
+    std::vector<std::unique_ptr<Input>> inputs;
+    std::vector<std::vector<float>> scratch;
+};
+
+#endif //COURSE_STREAMMIXER_H
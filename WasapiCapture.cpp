@@ -0,0 +1,190 @@
+#include "WasapiCapture.h"
+#include <avrt.h>
+#include <algorithm>
+#include <iostream>
+
+#pragma comment(lib,"ole32.lib")
+#pragma comment(lib,"avrt.lib")
+
+namespace {
+    const REFERENCE_TIME REFTIMES_PER_MS = 10000;
+
+    template<typename T>
+    void safeRelease(T*& ptr) {
+        if (ptr) {
+            ptr->Release();
+            ptr = nullptr;
+        }
+    }
+}
+
+WasapiCapture::WasapiCapture(bool exclusive)
+    : exclusive(exclusive), comInitialized(false), device(nullptr), audioClient(nullptr),
+      captureClient(nullptr), hEvent(nullptr), channels(0), stopThread(false), discontinuities(0) {
+}
+
+WasapiCapture::~WasapiCapture() {
+    close();
+}
+
+bool WasapiCapture::open(const CaptureFormat& format, int periodMs, BlockCallback callback) {
+    comInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+    channels = format.channels;
+    this->callback = std::move(callback);
+
+    IMMDeviceEnumerator* enumerator = nullptr;
+    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                                  __uuidof(IMMDeviceEnumerator), reinterpret_cast<void**>(&enumerator));
+    if (SUCCEEDED(hr)) {
+        hr = enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, &device);
+        enumerator->Release();
+    }
+    if (FAILED(hr)) {
+        std::cerr << "Failed to find default capture device. HRESULT: " << std::hex << hr << std::dec << std::endl;
+        close();
+        return false;
+    }
+
+    WAVEFORMATEX wfx{};
+    wfx.wFormatTag = WAVE_FORMAT_PCM;
+    wfx.nChannels = format.channels;
+    wfx.nSamplesPerSec = format.sampleRate;
+    wfx.wBitsPerSample = format.bitsPerSample;
+    wfx.nBlockAlign = (wfx.nChannels * wfx.wBitsPerSample) / 8;
+    wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
+
+    hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, reinterpret_cast<void**>(&audioClient));
+    REFERENCE_TIME defaultPeriod = 0, minPeriod = 0;
+    if (SUCCEEDED(hr)) {
+        hr = audioClient->GetDevicePeriod(&defaultPeriod, &minPeriod);
+    }
+    REFERENCE_TIME period = std::max<REFERENCE_TIME>(minPeriod, periodMs * REFTIMES_PER_MS);
+
+    if (SUCCEEDED(hr)) {
+        hr = initializeClient(wfx, period);
+    }
+    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+        // Exclusive mode wants a period that matches the device buffer alignment
+        UINT32 frames = 0;
+        audioClient->GetBufferSize(&frames);
+        period = static_cast<REFERENCE_TIME>(10000.0 * 1000 * frames / format.sampleRate + 0.5);
+        safeRelease(audioClient);
+        hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, reinterpret_cast<void**>(&audioClient));
+        if (SUCCEEDED(hr)) {
+            hr = initializeClient(wfx, period);
+        }
+    }
+    if (FAILED(hr)) {
+        std::cerr << "Failed to initialize WASAPI client. HRESULT: " << std::hex << hr << std::dec << std::endl;
+        close();
+        return false;
+    }
+
+    hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    hr = audioClient->SetEventHandle(hEvent);
+    if (SUCCEEDED(hr)) {
+        hr = audioClient->GetService(__uuidof(IAudioCaptureClient), reinterpret_cast<void**>(&captureClient));
+    }
+    if (FAILED(hr)) {
+        std::cerr << "Failed to get WASAPI capture client. HRESULT: " << std::hex << hr << std::dec << std::endl;
+        close();
+        return false;
+    }
+
+    std::cout << "WASAPI " << (exclusive ? "exclusive" : "shared") << " capture, period "
+              << period / (double)REFTIMES_PER_MS << " ms\n";
+    return true;
+}
+
+HRESULT WasapiCapture::initializeClient(const WAVEFORMATEX& wfx, REFERENCE_TIME period) {
+    if (exclusive) {
+        return audioClient->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                                       period, period, &wfx, nullptr);
+    }
+    // The shared mix format is usually float; let the audio engine convert to our PCM format
+    return audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED,
+                                   AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+                                   AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
+                                   period, 0, &wfx, nullptr);
+}
+
+bool WasapiCapture::start() {
+    if (!captureClient || thread.joinable()) return false;
+
+    stopThread = false;
+    thread = std::thread(&WasapiCapture::captureThread, this);
+
+    HRESULT hr = audioClient->Start();
+    if (FAILED(hr)) {
+        std::cerr << "Error starting WASAPI capture. HRESULT: " << std::hex << hr << std::dec << std::endl;
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void WasapiCapture::stop() {
+    if (!thread.joinable()) return;
+
+    stopThread = true;
+    SetEvent(hEvent);
+    thread.join();
+    audioClient->Stop();
+}
+
+void WasapiCapture::close() {
+    stop();
+    safeRelease(captureClient);
+    safeRelease(audioClient);
+    safeRelease(device);
+    if (hEvent) {
+        CloseHandle(hEvent);
+        hEvent = nullptr;
+    }
+    if (comInitialized) {
+        CoUninitialize();
+        comInitialized = false;
+    }
+}
+
+void WasapiCapture::captureThread() {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    DWORD taskIndex = 0;
+    HANDLE hTask = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    if (!hTask) {
+        std::cerr << "Failed to register capture thread with MMCSS\n";
+    }
+
+    while (!stopThread) {
+        WaitForSingleObject(hEvent, INFINITE);
+
+        UINT32 packetFrames = 0;
+        while (!stopThread && SUCCEEDED(captureClient->GetNextPacketSize(&packetFrames)) && packetFrames > 0) {
+            BYTE* data = nullptr;
+            UINT32 frames = 0;
+            DWORD flags = 0;
+            if (FAILED(captureClient->GetBuffer(&data, &frames, &flags, nullptr, nullptr))) {
+                break;
+            }
+
+            if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) {
+                ++discontinuities;
+            }
+
+            size_t samples = static_cast<size_t>(frames) * channels;
+            if (callback) {
+                if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+                    silence.assign(samples, 0);
+                    callback(silence.data(), samples);
+                } else {
+                    callback(reinterpret_cast<const short*>(data), samples);
+                }
+            }
+            captureClient->ReleaseBuffer(frames);
+        }
+    }
+
+    if (hTask) AvRevertMmThreadCharacteristics(hTask);
+    CoUninitialize();
+}
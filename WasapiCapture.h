@@ -0,0 +1,49 @@
+#ifndef COURSE_WASAPICAPTURE_H
+#define COURSE_WASAPICAPTURE_H
+
+#include "CaptureBackend.h"
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Event-driven WASAPI capture from the default input device. Packets are read
+// on a thread registered with MMCSS ("Pro Audio") as soon as the device
+// signals them, with the period as small as the device allows.
+class WasapiCapture : public CaptureBackend {
+public:
+    explicit WasapiCapture(bool exclusive);
+    ~WasapiCapture() override;
+
+    bool open(const CaptureFormat& format, int periodMs, BlockCallback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    const char* name() const override { return exclusive ? "wasapi-exclusive" : "wasapi"; }
+    uint64_t getOverruns() const override { return discontinuities; }
+
+private:
+    HRESULT initializeClient(const WAVEFORMATEX& wfx, REFERENCE_TIME period);
+    void captureThread();
+
+    bool exclusive;
+    bool comInitialized;
+    IMMDevice* device;
+    IAudioClient* audioClient;
+    IAudioCaptureClient* captureClient;
+    HANDLE hEvent;
+    int channels;
+    BlockCallback callback;
+    std::vector<short> silence;
+
+    std::thread thread;
+    std::atomic<bool> stopThread;
+    std::atomic<uint64_t> discontinuities;
+};
+
+#endif //COURSE_WASAPICAPTURE_H
@@ -0,0 +1,235 @@
+#include "WavWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const size_t HEADER_SIZE = 44;
+
+    void put16(unsigned char* at, uint16_t value) {
+        std::memcpy(at, &value, 2);
+    }
+
+    void put32(unsigned char* at, uint32_t value) {
+        std::memcpy(at, &value, 4);
+    }
+
+    // End of the last complete chunk in the run starting at offset
+    uintmax_t completeChunksEnd(std::FILE* in, uintmax_t offset, uintmax_t fileSize) {
+        unsigned char chunk[8];
+        while (offset + 8 <= fileSize) {
+            std::fseek(in, static_cast<long>(offset), SEEK_SET);
+            if (std::fread(chunk, 1, 8, in) != 8) break;
+            uint32_t size = 0;
+            std::memcpy(&size, chunk + 4, 4);
+            uintmax_t next = offset + 8 + size + (size & 1);
+            if (next > fileSize) break;
+            offset = next;
+        }
+        return offset;
+    }
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const std::string& filename, int sampleRate, int channels, int bitsPerSample) {
+    close();
+
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error opening file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    this->filename = filename;
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+    this->bitsPerSample = bitsPerSample;
+    dataSize = 0;
+    trailerSize = 0;
+    info.clear();
+    chunks.clear();
+
+    writeHeader();
+    return true;
+}
+
+void WavWriter::write(const short* data, size_t samples) {
+    if (!file || samples == 0) return;
+
+    // Whole frames only, so a full file still ends on a frame boundary
+    size_t frameBytes = sizeof(short) * channels;
+    size_t room = (MAX_DATA_SIZE - dataSize) / frameBytes * frameBytes;
+    size_t bytes = std::min(samples * sizeof(short), room);
+    if (bytes < samples * sizeof(short)) {
+        if (room > 0) std::cerr << "WAV size limit reached, dropping samples: " << filename << std::endl;
+        if (bytes == 0) return;
+    }
+    std::fwrite(data, 1, bytes, file);
+    dataSize += static_cast<uint32_t>(bytes);
+}
+
+bool WavWriter::checkpoint(bool sync) {
+    if (!file) return false;
+
+    std::fseek(file, 0, SEEK_SET);
+    writeHeader();
+    std::fseek(file, 0, SEEK_END);
+    if (std::fflush(file) != 0) return false;
+    return !sync || syncFile(file);
+}
+
+void WavWriter::close() {
+    if (!file) return;
+
+    // The header gets its final sizes before the trailer is appended, so a
+    // crash in between still tells repair() where the audio ends
+    std::string trailer = makeTrailer();
+    trailerSize = static_cast<uint32_t>(trailer.size());
+    std::fseek(file, 0, SEEK_SET);
+    writeHeader();
+    std::fflush(file);
+    std::fseek(file, 0, SEEK_END);
+    std::fwrite(trailer.data(), 1, trailer.size(), file);
+    std::fclose(file);
+    file = nullptr;
+}
+
+void WavWriter::addInfo(const std::string& tag, const std::string& text) {
+    std::string value = text + '\0';
+    info += tag.substr(0, 4);
+    uint32_t size = static_cast<uint32_t>(value.size());
+    info.append(reinterpret_cast<const char*>(&size), 4);
+    info += value;
+    if (value.size() & 1) info += '\0';
+}
+
+void WavWriter::addChunk(const std::string& id, const std::string& payload) {
+    chunks += id.substr(0, 4);
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    chunks.append(reinterpret_cast<const char*>(&size), 4);
+    chunks += payload;
+    if (payload.size() & 1) chunks += '\0';
+}
+
+std::string WavWriter::makeTrailer() const {
+    // Chunks must start on an even offset
+    std::string trailer;
+    if (dataSize & 1) trailer += '\0';
+    if (!info.empty()) {
+        trailer += "LIST";
+        uint32_t size = static_cast<uint32_t>(info.size() + 4);
+        trailer.append(reinterpret_cast<const char*>(&size), 4);
+        trailer += "INFO" + info;
+    }
+    trailer += chunks;
+    return trailer;
+}
+
+bool WavWriter::isOpen() const {
+    return file != nullptr;
+}
+
+const std::string& WavWriter::getFilename() const {
+    return filename;
+}
+
+uint32_t WavWriter::getDataSize() const {
+    return dataSize;
+}
+
+bool WavWriter::syncFile(std::FILE* file) {
+    std::fflush(file);
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool WavWriter::repair(const std::string& filename, uint32_t& dataSize) {
+    std::error_code ec;
+    uintmax_t fileSize = std::filesystem::file_size(filename, ec);
+    if (ec || fileSize < HEADER_SIZE) return false;
+
+    std::FILE* in = std::fopen(filename.c_str(), "r+b");
+    if (!in) return false;
+
+    unsigned char header[HEADER_SIZE];
+    bool ours = std::fread(header, 1, HEADER_SIZE, in) == HEADER_SIZE &&
+                std::memcmp(header, "RIFF", 4) == 0 && std::memcmp(header + 8, "WAVEfmt ", 8) == 0 &&
+                std::memcmp(header + 36, "data", 4) == 0;
+    uint16_t blockAlign = 0;
+    uint32_t riffSize = 0;
+    std::memcpy(&blockAlign, header + 32, 2);
+    std::memcpy(&riffSize, header + 4, 4);
+    std::memcpy(&dataSize, header + 40, 4);
+    if (!ours || blockAlign == 0) {
+        std::fclose(in);
+        return false;
+    }
+    if (riffSize + 8 == fileSize && HEADER_SIZE + dataSize <= fileSize) {
+        // Closed properly, the crash came before the journal heard about it
+        std::fclose(in);
+        return true;
+    }
+
+    uintmax_t keep;
+    uintmax_t audioEnd = HEADER_SIZE + dataSize + (dataSize & 1);
+    if (riffSize > 36 + dataSize && audioEnd <= fileSize) {
+        // Only close() counts a trailer in the RIFF size: the audio is complete
+        // and the metadata chunks that made it to disk are kept
+        keep = completeChunksEnd(in, audioEnd, fileSize);
+        put32(header + 4, static_cast<uint32_t>(keep - 8));
+    } else {
+        // A checkpointed header; a torn last write can leave part of a frame behind
+        uintmax_t frames = (fileSize - HEADER_SIZE) / blockAlign;
+        dataSize = static_cast<uint32_t>(std::min<uintmax_t>(frames * blockAlign, UINT32_MAX - 36));
+        keep = HEADER_SIZE + dataSize;
+        put32(header + 4, 36 + dataSize);
+        put32(header + 40, dataSize);
+    }
+    std::fseek(in, 0, SEEK_SET);
+    bool ok = std::fwrite(header, 1, HEADER_SIZE, in) == HEADER_SIZE;
+    ok = syncFile(in) && ok;
+    std::fclose(in);
+
+    if (ok && fileSize != keep) {
+        std::filesystem::resize_file(filename, keep, ec);
+    }
+    return ok && !ec;
+}
+
+void WavWriter::writeHeader() {
+    unsigned char header[HEADER_SIZE];
+
+    // RIFF chunk
+    std::memcpy(header, "RIFF", 4);
+    put32(header + 4, 36 + dataSize + trailerSize);
+    std::memcpy(header + 8, "WAVE", 4);
+
+    // fmt subchunk
+    std::memcpy(header + 12, "fmt ", 4);
+    put32(header + 16, 16);
+    put16(header + 20, 1); // PCM
+    put16(header + 22, static_cast<uint16_t>(channels));
+    put32(header + 24, static_cast<uint32_t>(sampleRate));
+    put32(header + 28, static_cast<uint32_t>(sampleRate * channels * bitsPerSample / 8));
+    put16(header + 32, static_cast<uint16_t>(channels * bitsPerSample / 8));
+    put16(header + 34, static_cast<uint16_t>(bitsPerSample));
+
+    // data subchunk
+    std::memcpy(header + 36, "data", 4);
+    put32(header + 40, dataSize);
+
+    std::fwrite(header, 1, HEADER_SIZE, file);
+}
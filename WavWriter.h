@@ -0,0 +1,59 @@
+#ifndef COURSE_WAVWRITER_H
+#define COURSE_WAVWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Streams PCM blocks into a WAV file. The header is written up front with
+// zero sizes and patched on close, so samples never have to be buffered.
+// checkpoint() patches the header in between, so a file cut short by a
+// crash is valid up to its last checkpoint; repair() fixes the rest.
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter();
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool open(const std::string& filename, int sampleRate, int channels, int bitsPerSample);
+    void write(const short* data, size_t samples);
+    // Flushes the samples and header to the OS, and to the disk when sync is set
+    bool checkpoint(bool sync);
+    void close();
+
+    // Metadata written after the audio on close: a LIST/INFO entry (tag such
+    // as "ICRD") or a chunk of its own
+    void addInfo(const std::string& tag, const std::string& text);
+    void addChunk(const std::string& id, const std::string& payload);
+
+    bool isOpen() const;
+    const std::string& getFilename() const;
+    uint32_t getDataSize() const;
+
+    // Sets the RIFF sizes of a file written by this class from its actual length
+    static bool repair(const std::string& filename, uint32_t& dataSize);
+    static bool syncFile(std::FILE* file);
+
+    // Largest data chunk, leaving room in the 32-bit RIFF size for the header
+    // and trailer; write() drops what does not fit
+    static const uint32_t MAX_DATA_SIZE = 0xFFFFFFFFu - (1u << 20);
+
+private:
+    void writeHeader();
+    std::string makeTrailer() const;
+
+    std::FILE* file = nullptr;
+    std::string filename;
+    int sampleRate = 0;
+    int channels = 0;
+    int bitsPerSample = 0;
+    uint32_t dataSize = 0;
+    uint32_t trailerSize = 0;
+    std::string info;
+    std::string chunks;
+};
+
+#endif //COURSE_WAVWRITER_H
@@ -0,0 +1,121 @@
+#include "WinMMCapture.h"
+#include <algorithm>
+#include <iostream>
+
+#pragma comment(lib,"winmm.lib")
+
+WinMMCapture::WinMMCapture() : hWaveIn(nullptr), hEvent(nullptr), stopThread(false) {
+    ZeroMemory(&wfx, sizeof(WAVEFORMATEX));
+}
+
+WinMMCapture::~WinMMCapture() {
+    close();
+}
+
+bool WinMMCapture::open(const CaptureFormat& format, int periodMs, BlockCallback callback) {
+    wfx.wFormatTag = WAVE_FORMAT_PCM;
+    wfx.nChannels = format.channels;
+    wfx.nSamplesPerSec = format.sampleRate;
+    wfx.wBitsPerSample = format.bitsPerSample;
+    wfx.nBlockAlign = (wfx.nChannels * wfx.wBitsPerSample) / 8;
+    wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
+    this->callback = std::move(callback);
+
+    hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    MMRESULT result = waveInOpen(&hWaveIn, WAVE_MAPPER, &wfx, (DWORD_PTR)hEvent, 0, CALLBACK_EVENT);
+    if (result != MMSYSERR_NOERROR) {
+        std::cerr << "Failed to open recording device. Error code: " << result << std::endl;
+        CloseHandle(hEvent);
+        hEvent = nullptr;
+        hWaveIn = nullptr;
+        return false;
+    }
+
+    // waveIn drops data with very short buffers, so keep ~200 ms queued in total
+    const DWORD bufferMs = std::max(periodMs, 50);
+    const DWORD bufferBytes = (wfx.nAvgBytesPerSec * bufferMs) / 1000 / wfx.nBlockAlign * wfx.nBlockAlign;
+    const int bufferCount = std::max<int>(2, 200 / bufferMs);
+
+    buffers.assign(bufferCount, std::vector<BYTE>(bufferBytes));
+    headers.resize(bufferCount);
+
+    for (int i = 0; i < bufferCount; ++i) {
+        ZeroMemory(&headers[i], sizeof(WAVEHDR));
+        headers[i].lpData = reinterpret_cast<LPSTR>(buffers[i].data());
+        headers[i].dwBufferLength = bufferBytes;
+
+        result = waveInPrepareHeader(hWaveIn, &headers[i], sizeof(WAVEHDR));
+        if (result == MMSYSERR_NOERROR) {
+            result = waveInAddBuffer(hWaveIn, &headers[i], sizeof(WAVEHDR));
+        }
+        if (result != MMSYSERR_NOERROR) {
+            std::cerr << "Error preparing buffer " << i << ". Error code: " << result << std::endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WinMMCapture::start() {
+    if (!hWaveIn || thread.joinable()) return false;
+
+    stopThread = false;
+    thread = std::thread(&WinMMCapture::captureThread, this);
+
+    MMRESULT result = waveInStart(hWaveIn);
+    if (result != MMSYSERR_NOERROR) {
+        std::cerr << "Error starting capture. Error code: " << result << std::endl;
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void WinMMCapture::stop() {
+    if (!thread.joinable()) return;
+
+    stopThread = true;
+    waveInStop(hWaveIn);
+    waveInReset(hWaveIn);
+    SetEvent(hEvent);
+    thread.join();
+}
+
+void WinMMCapture::close() {
+    stop();
+    if (hWaveIn) {
+        for (auto& header : headers) {
+            if (header.dwFlags & WHDR_PREPARED) {
+                waveInUnprepareHeader(hWaveIn, &header, sizeof(WAVEHDR));
+            }
+        }
+        waveInClose(hWaveIn);
+        hWaveIn = nullptr;
+    }
+    if (hEvent) {
+        CloseHandle(hEvent);
+        hEvent = nullptr;
+    }
+    headers.clear();
+    buffers.clear();
+}
+
+void WinMMCapture::captureThread() {
+    size_t next = 0;
+
+    while (!stopThread) {
+        WaitForSingleObject(hEvent, INFINITE);
+
+        // Buffers complete in the order they were queued
+        while (!stopThread && (headers[next].dwFlags & WHDR_DONE)) {
+            WAVEHDR& hdr = headers[next];
+            if (callback && hdr.dwBytesRecorded > 0) {
+                callback(reinterpret_cast<const short*>(hdr.lpData), hdr.dwBytesRecorded / sizeof(short));
+            }
+            hdr.dwFlags &= ~WHDR_DONE;
+            waveInAddBuffer(hWaveIn, &hdr, sizeof(WAVEHDR));
+            next = (next + 1) % headers.size();
+        }
+    }
+}
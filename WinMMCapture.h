@@ -0,0 +1,41 @@
+#ifndef COURSE_WINMMCAPTURE_H
+#define COURSE_WINMMCAPTURE_H
+
+#include "CaptureBackend.h"
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mmsystem.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Legacy waveIn capture. Buffers are signalled through an event and handled on
+// our own thread, so the block callback is never run inside the driver callback.
+class WinMMCapture : public CaptureBackend {
+public:
+    WinMMCapture();
+    ~WinMMCapture() override;
+
+    bool open(const CaptureFormat& format, int periodMs, BlockCallback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    const char* name() const override { return "winmm"; }
+
+private:
+    void captureThread();
+
+    HWAVEIN hWaveIn;
+    HANDLE hEvent;
+    WAVEFORMATEX wfx;
+    std::vector<WAVEHDR> headers;
+    std::vector<std::vector<BYTE>> buffers;
+    BlockCallback callback;
+
+    std::thread thread;
+    std::atomic<bool> stopThread;
+};
+
+#endif //COURSE_WINMMCAPTURE_H
@@ -0,0 +1,106 @@
+// Duplicate lookup latency against a large fingerprint index, plus a recall
+// check with real audio (a noisy, quieter replay must match, a new sound must not).
+// Usage: fingerprint_bench [clips=100000] [windowClips=10000] [hashesPerClip=200] [index=fp_bench]
+#include "FingerprintIndex.h"
+#include "Fingerprinter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<short> makeClip(std::mt19937& rng, double gain, double noise, int sampleRate) {
+    // A few seconds of stepped tones, like an alarm or a chime
+    std::uniform_real_distribution<double> freq(300.0, 4000.0);
+    std::normal_distribution<double> hiss(0.0, noise * 32767.0);
+    std::vector<double> tones(12);
+    for (double& f : tones) f = freq(rng);
+
+    std::vector<short> clip(static_cast<size_t>(sampleRate) * 3);
+    for (size_t i = 0; i < clip.size(); ++i) {
+        double t = static_cast<double>(i) / sampleRate;
+        size_t step = i * tones.size() / clip.size();
+        double v = 0.5 * std::sin(2.0 * M_PI * tones[step] * t) + 0.25 * std::sin(2.0 * M_PI * tones[(step + 5) % tones.size()] * t);
+        clip[i] = static_cast<short>(std::clamp(gain * v * 32767.0 + hiss(rng), -32768.0, 32767.0));
+    }
+    return clip;
+}
+
+static std::vector<FingerprintHash> fingerprint(const std::vector<short>& clip, int sampleRate) {
+    Fingerprinter fp(sampleRate, 1);
+    fp.push(clip.data(), clip.size());
+    return fp.getHashes();
+}
+
+int main(int argc, char* argv[]) {
+    size_t clips = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t windowClips = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000;
+    size_t hashesPerClip = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200;
+    std::string path = argc > 4 ? argv[4] : "fp_bench";
+    const int sampleRate = 44100;
+    const int64_t windowMs = 3600 * 1000LL;
+    const int64_t now = 1000LL * 1000 * 1000 * 1000;
+
+    for (const char* ext : {".clips", ".hashes"}) std::remove((path + ext).c_str());
+    FingerprintIndex index;
+    if (!index.open(path, now - windowMs)) return 1;
+
+    // Bulk fill with random hashes: only the last windowClips are recent enough to be searched
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> anyHash(0, (1u << 24) - 1);
+    std::vector<FingerprintHash> hashes(hashesPerClip);
+    auto fillStart = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < clips; ++c) {
+        for (size_t h = 0; h < hashesPerClip; ++h) hashes[h] = {anyHash(rng), static_cast<uint32_t>(h)};
+        int64_t when = c + windowClips < clips ? now - 2 * windowMs : now - windowMs / 2;
+        index.add("bulk_" + std::to_string(c), when, hashes);
+    }
+    double fillSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fillStart).count();
+
+    // A restart only reloads the clips inside the window
+    index.close();
+    auto openStart = std::chrono::steady_clock::now();
+    if (!index.open(path, now - windowMs)) return 1;
+    double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+
+    std::vector<short> original = makeClip(rng, 0.8, 0.002, sampleRate);
+    index.add("original", now - 1000, fingerprint(original, sampleRate));
+
+    std::mt19937 replayRng(7);
+    std::vector<short> replay = makeClip(replayRng, 0.0, 0.0, sampleRate);
+    for (size_t i = 0; i < replay.size(); ++i) {
+        // Same sound at half the level with extra noise, starting 1234 samples later
+        double v = 0.5 * original[std::min(i + 1234, original.size() - 1)] + std::normal_distribution<double>(0.0, 300.0)(replayRng);
+        replay[i] = static_cast<short>(std::clamp(v, -32768.0, 32767.0));
+    }
+    std::vector<FingerprintHash> replayHashes = fingerprint(replay, sampleRate);
+    std::vector<FingerprintHash> otherHashes = fingerprint(makeClip(rng, 0.8, 0.002, sampleRate), sampleRate);
+
+    FingerprintIndex::Match match;
+    bool replayFound = index.findMatch(replayHashes, now - windowMs, match) && match.name == "original";
+    int replayVotes = match.votes;
+    bool otherFound = index.findMatch(otherHashes, now - windowMs, match);
+
+    std::vector<double> latencyUs;
+    for (int i = 0; i < 200; ++i) {
+        const auto& query = i % 2 ? replayHashes : otherHashes;
+        auto started = std::chrono::steady_clock::now();
+        index.findMatch(query, now - windowMs, match);
+        latencyUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count());
+    }
+    std::sort(latencyUs.begin(), latencyUs.end());
+
+    std::printf("clips: %zu (%zu inside the window), %zu hashes each, filled in %.1f s, reopened in %.2f s\n",
+                index.getClipCount(), windowClips, hashesPerClip, fillSeconds, openSeconds);
+    std::printf("replay matched: %s (%d of %zu hashes), unrelated clip matched: %s\n",
+                replayFound ? "yes" : "NO", replayVotes, replayHashes.size(), otherFound ? "YES" : "no");
+    std::printf("lookup us: p50 %.0f  p99 %.0f  max %.0f\n",
+                latencyUs[latencyUs.size() / 2], latencyUs[latencyUs.size() * 99 / 100], latencyUs.back());
+
+    index.close();
+    for (const char* ext : {".clips", ".hashes"}) std::remove((path + ext).c_str());
+    return replayFound && !otherFound ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+// Stand-in for an export collector: accepts "PUT /<path>/<name>" uploads on
+// localhost and stores the body as <dir>/<name>, printing size and throughput.
+// Every <fail_every>th request is answered with 503 to exercise the retries.
+// Usage: http_sink <port> <dir> [fail_every=0]
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void reply(int fd, const char* status) {
+    std::string response = std::string("HTTP/1.1 ") + status + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+}
+
+static void serve(int fd, const std::filesystem::path& dir, bool fail) {
+    auto started = std::chrono::steady_clock::now();
+    std::string head;
+    char buffer[64 * 1024];
+    size_t end;
+    while ((end = head.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+        if (got <= 0) return;
+        head.append(buffer, got);
+    }
+    std::string body = head.substr(end + 4);
+    head.resize(end);
+
+    size_t lengthAt = head.find("Content-Length: ");
+    if (head.rfind("PUT /", 0) != 0 || lengthAt == std::string::npos) {
+        reply(fd, "400 Bad Request");
+        return;
+    }
+    size_t length = std::strtoull(head.c_str() + lengthAt + 16, nullptr, 10);
+    std::string target = head.substr(4, head.find(' ', 4) - 4);
+    std::string name = target.substr(target.rfind('/') + 1);
+
+    while (body.size() < length) {
+        ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+        if (got <= 0) {
+            std::printf("%s: connection lost after %zu of %zu bytes\n", name.c_str(), body.size(), length);
+            return;
+        }
+        body.append(buffer, got);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (fail || name.empty() || name.find("..") != std::string::npos) {
+        std::printf("%s: %zu bytes, rejected\n", name.c_str(), length);
+        reply(fd, "503 Service Unavailable");
+        return;
+    }
+    std::FILE* out = std::fopen((dir / name).string().c_str(), "wb");
+    if (!out || std::fwrite(body.data(), 1, length, out) != length) {
+        if (out) std::fclose(out);
+        reply(fd, "500 Internal Server Error");
+        return;
+    }
+    std::fclose(out);
+    std::printf("%s: %zu bytes in %.2f s (%.0f kbit/s)\n", name.c_str(), length, seconds,
+                seconds > 0 ? length * 8 / 1000.0 / seconds : 0.0);
+    std::fflush(stdout);
+    reply(fd, "201 Created");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: http_sink <port> <dir> [fail_every=0]\n");
+        return 1;
+    }
+    int port = std::atoi(argv[1]);
+    std::filesystem::path dir = argv[2];
+    int failEvery = argc > 3 ? std::atoi(argv[3]) : 0;
+    std::filesystem::create_directories(dir);
+
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, 16) != 0) {
+        std::perror("http_sink");
+        return 1;
+    }
+    std::printf("Listening on 127.0.0.1:%d, storing in %s\n", port, dir.string().c_str());
+    std::fflush(stdout);
+
+    for (int request = 1;; ++request) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        serve(fd, dir, failEvery > 0 && request % failEvery == 0);
+        close(fd);
+    }
+}
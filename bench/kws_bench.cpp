@@ -0,0 +1,139 @@
+// Offline accuracy and CPU cost of the keyword trigger over labelled WAV files.
+// Usage: kws_bench <model> <manifest> [threshold=0.8]
+// Manifest lines are "<file.wav> <keyword>", with "-" for clips that must not fire.
+#include "KeywordSpotter.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Wav {
+    int sampleRate = 0;
+    int channels = 0;
+    std::vector<short> samples;
+};
+
+static bool readWav(const std::string& path, Wav& wav) {
+    std::ifstream file(path, std::ios::binary);
+    char riff[12];
+    if (!file.read(riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    char id[4];
+    uint32_t size;
+    int bits = 0;
+    while (file.read(id, 4) && file.read(reinterpret_cast<char*>(&size), 4)) {
+        if (std::memcmp(id, "fmt ", 4) == 0) {
+            uint16_t format, channels, blockAlign, bitsPerSample;
+            uint32_t rate, byteRate;
+            file.read(reinterpret_cast<char*>(&format), 2);
+            file.read(reinterpret_cast<char*>(&channels), 2);
+            file.read(reinterpret_cast<char*>(&rate), 4);
+            file.read(reinterpret_cast<char*>(&byteRate), 4);
+            file.read(reinterpret_cast<char*>(&blockAlign), 2);
+            file.read(reinterpret_cast<char*>(&bitsPerSample), 2);
+            file.seekg(size - 16, std::ios::cur);
+            if (format != 1) return false;
+            wav.sampleRate = static_cast<int>(rate);
+            wav.channels = channels;
+            bits = bitsPerSample;
+        } else if (std::memcmp(id, "data", 4) == 0) {
+            if (bits != 16) return false;
+            wav.samples.resize(size / 2);
+            file.read(reinterpret_cast<char*>(wav.samples.data()), wav.samples.size() * 2);
+            return wav.channels > 0;
+        } else {
+            file.seekg(size + (size & 1), std::ios::cur);
+        }
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: kws_bench <model> <manifest> [threshold=0.8]\n");
+        return 2;
+    }
+    float threshold = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 0.8f;
+
+    std::ifstream manifest(argv[2]);
+    if (!manifest.is_open()) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[2]);
+        return 2;
+    }
+
+    int positives = 0, hits = 0, wrongKeyword = 0, falseAlarms = 0;
+    double negativeSeconds = 0.0, audioSeconds = 0.0, cpuSeconds = 0.0;
+    size_t memoryBytes = 0;
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::istringstream in(line);
+        std::string path, expected;
+        if (!(in >> path >> expected) || path[0] == '#') continue;
+
+        Wav wav;
+        if (!readWav(path, wav)) {
+            std::fprintf(stderr, "Skipping %s: not a 16-bit PCM WAV\n", path.c_str());
+            continue;
+        }
+
+        KeywordSpotter spotter(wav.sampleRate, wav.channels);
+        std::string error;
+        if (!spotter.load(argv[1], error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        spotter.setThreshold(threshold);
+        memoryBytes = spotter.getMemoryBytes();
+
+        // Feed 10 ms packets like a capture backend would
+        size_t packet = static_cast<size_t>(wav.sampleRate / 100) * wav.channels;
+        std::vector<std::string> heard;
+        auto started = std::chrono::steady_clock::now();
+        for (size_t pos = 0; pos < wav.samples.size(); pos += packet) {
+            int keyword = spotter.push(wav.samples.data() + pos, std::min(packet, wav.samples.size() - pos));
+            if (keyword >= 0) heard.push_back(spotter.getLabels()[keyword]);
+        }
+        cpuSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        double seconds = static_cast<double>(wav.samples.size()) / wav.channels / wav.sampleRate;
+        audioSeconds += seconds;
+
+        bool positive = expected != "-";
+        bool hit = false;
+        for (const std::string& name : heard) {
+            if (name == expected) hit = true;
+            else if (positive) ++wrongKeyword;
+            else ++falseAlarms;
+        }
+        if (positive) {
+            ++positives;
+            hits += hit ? 1 : 0;
+        } else {
+            negativeSeconds += seconds;
+        }
+
+        std::printf("%-40s expected %-12s heard", path.c_str(), expected.c_str());
+        for (const std::string& name : heard) std::printf(" %s", name.c_str());
+        std::printf("%s\n", heard.empty() ? " nothing" : "");
+    }
+
+    if (audioSeconds == 0.0) {
+        std::fprintf(stderr, "No usable files in %s\n", argv[2]);
+        return 2;
+    }
+    std::printf("\nrecall: %d/%d (%.1f%%), wrong keyword: %d\n",
+                hits, positives, positives ? 100.0 * hits / positives : 0.0, wrongKeyword);
+    std::printf("false alarms: %d in %.1f s of negative audio (%.2f per hour)\n",
+                falseAlarms, negativeSeconds, negativeSeconds > 0 ? falseAlarms * 3600.0 / negativeSeconds : 0.0);
+    std::printf("cpu: %.3f s for %.1f s of audio (%.1f%% of one core), model state %zu KiB\n",
+                cpuSeconds, audioSeconds, 100.0 * cpuSeconds / audioSeconds, memoryBytes / 1024);
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Responsiveness and idle cost of the recorder's thread loops, on the mock backend.
+// Usage: loop_bench [iterations=20] [idle_seconds=10] [period_ms=10]
+//
+// Stop latency: a recording is running when stop() is called; stop() returns
+// once the capture thread is down and the WAV file is closed.
+// Wakeups: the recorder monitors silence, then records a tone; voluntary
+// context switches of the process are counted, minus one per packet for the
+// mock device thread.
+#include "AudioRecorder.h"
+#include "MockCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+static long voluntarySwitches() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+}
+
+static RecorderConfig benchConfig(const std::filesystem::path& dir, int periodMs) {
+    RecorderConfig config;
+    config.backend = "mock";
+    config.channels = 1;
+    config.periodMs = periodMs;
+    config.recordSeconds = 600;
+    config.outputPrefix = (dir / "loop_").string();
+    config.journal = "";
+    config.recordingIndex = "";
+    return config;
+}
+
+// Wakeups per second while monitoring the source (silence when empty)
+static void measureWakeups(const char* label, const RecorderConfig& config, const std::vector<short>& source, int seconds) {
+    AudioRecorder recorder(config);
+    recorder.setLevelLogging(false);
+    auto backend = std::make_unique<MockCapture>();
+    backend->setSource(source, true);
+    recorder.setBackend(std::move(backend));
+    recorder.start();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    long switches = voluntarySwitches();
+    uint64_t packets = recorder.getMetrics().packets.load();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    double total = static_cast<double>(voluntarySwitches() - switches) / seconds;
+    double capture = static_cast<double>(recorder.getMetrics().packets.load() - packets) / seconds;
+    recorder.stop();
+
+    std::printf("%s wakeups: %.1f/s in total, %.1f/s besides the %.1f/s capture packets\n",
+                label, total, total - capture, capture);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    int idleSeconds = argc > 2 ? std::atoi(argv[2]) : 10;
+    int periodMs = argc > 3 ? std::atoi(argv[3]) : 10;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "course_loop_bench";
+    std::filesystem::create_directories(dir);
+    RecorderConfig config = benchConfig(dir, periodMs);
+
+    std::vector<short> tone(config.sampleRate);
+    for (size_t i = 0; i < tone.size(); ++i) {
+        tone[i] = static_cast<short>(8000 * std::sin(2 * 3.14159265358979 * 440 * i / config.sampleRate));
+    }
+
+    std::vector<double> stopMs;
+    for (int i = 0; i < iterations; ++i) {
+        AudioRecorder recorder(config);
+        recorder.setLevelLogging(false);
+        auto backend = std::make_unique<MockCapture>();
+        backend->setSource(tone, true);
+        recorder.setBackend(std::move(backend));
+
+        recorder.start();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!recorder.isRecordingActive() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        // Land at a random point between blocks and loop iterations
+        std::this_thread::sleep_for(std::chrono::milliseconds(300 + std::rand() % 250));
+
+        auto started = std::chrono::steady_clock::now();
+        recorder.stop();
+        stopMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count());
+    }
+    std::sort(stopMs.begin(), stopMs.end());
+    if (!stopMs.empty()) {
+        std::printf("stop to file closed: p50 %.1f ms  p95 %.1f ms  max %.1f ms  (%d runs)\n",
+                    stopMs[stopMs.size() / 2], stopMs[stopMs.size() * 95 / 100], stopMs.back(), iterations);
+    }
+
+    measureWakeups("idle", config, {}, idleSeconds);
+    measureWakeups("recording", config, tone, idleSeconds);
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -1,10 +1,94 @@
 #include  "AudioRecorder.h"
+#include "ConfigWatcher.h"
+#include "ControlServer.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
+// Long-running service mode: no console level output, controlled over the local endpoint
+static int runDaemon(AudioRecorder& recorder, const std::string& endpoint, ConfigWatcher* watcher) {
+    recorder.setLevelLogging(false);
 
-int main() {
+    ControlServer server(recorder, endpoint);
+    if (watcher) {
+        server.setReloadHandler([watcher] { return watcher->reloadNow(); });
+    }
+    if (!server.start()) {
+        return 1;
+    }
+
+    recorder.handleSignals();
+    recorder.start();
+    // Returns on a signal, the "shutdown" command or a capture failure
+    recorder.waitUntilStopped();
+
+    server.stop();
+    recorder.stop();
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
-    AudioRecorder recorder;
+#endif
+    bool daemon = false;
+    std::string endpoint = ControlServer::defaultEndpoint();
+    std::string configPath;
+    std::string backend;
+    int sampleRate = 0;
+    int channels = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--backend" && i + 1 < argc) {
+            backend = argv[++i];
+        } else if (arg == "--rate" && i + 1 < argc) {
+            sampleRate = std::stoi(argv[++i]);
+        } else if (arg == "--channels" && i + 1 < argc) {
+            channels = std::stoi(argv[++i]);
+        } else if (arg == "--config" && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (arg == "--daemon") {
+            daemon = true;
+        } else if (arg == "--control" && i + 1 < argc) {
+            endpoint = argv[++i];
+        }
+    }
+
+    // Command line flags win over the file, also after a reload
+    auto withFlags = [&](RecorderConfig config) {
+        if (!backend.empty()) config.backend = backend;
+        if (sampleRate > 0) config.sampleRate = sampleRate;
+        if (channels > 0) config.channels = channels;
+        return config;
+    };
+
+    RecorderConfig config;
+    if (!configPath.empty()) {
+        std::string error;
+        if (!RecorderConfig::load(configPath, config, error)) {
+            std::cerr << "Config error: " << error << "\n";
+            return 1;
+        }
+    }
+    AudioRecorder recorder(withFlags(config));
+
+    std::unique_ptr<ConfigWatcher> watcher;
+    if (!configPath.empty()) {
+        watcher = std::make_unique<ConfigWatcher>(configPath, RecorderConfig(), [&](const RecorderConfig& loaded) {
+            recorder.applyConfig(withFlags(loaded));
+        });
+        watcher->start();
+    }
+
+    if (daemon) {
+        return runDaemon(recorder, endpoint, watcher.get());
+    }
     recorder.run();
     return 0;
-}
\ No newline at end of file
+}
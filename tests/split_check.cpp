@@ -0,0 +1,95 @@
+// Level-triggered recordings on the mock backend: pauses longer than
+// split_pause_ms but shorter than end_pause_ms must split one recording into
+// _N segments, and a pause longer than end_pause_ms must end it.
+// Exits non-zero on failure.
+#include "AudioRecorder.h"
+#include "MockCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tone bursts of toneMs separated by gapMs of silence; silence after the last one
+static std::vector<short> bursts(int sampleRate, int count, int toneMs, int gapMs) {
+    std::vector<short> samples;
+    for (int burst = 0; burst < count; ++burst) {
+        for (int i = 0; i < sampleRate * toneMs / 1000; ++i) {
+            samples.push_back(static_cast<short>(8000 * std::sin(2 * 3.14159265358979 * 440 * i / sampleRate)));
+        }
+        samples.resize(samples.size() + sampleRate * gapMs / 1000, 0);
+    }
+    return samples;
+}
+
+// Records the source once and returns the names of the files it produced
+static std::vector<std::string> record(const std::filesystem::path& dir, const char* name,
+                                       const std::vector<short>& source, const RecorderConfig& base) {
+    RecorderConfig config = base;
+    config.outputPrefix = (dir / name).string() + "_";
+
+    AudioRecorder recorder(config);
+    recorder.setLevelLogging(false);
+    auto backend = std::make_unique<MockCapture>();
+    backend->setSource(source, false);
+    recorder.setBackend(std::move(backend));
+    recorder.start();
+
+    // The source plays in real time; the last recording ends end_pause_ms after the last burst
+    int sourceMs = static_cast<int>(1000LL * source.size() / config.sampleRate);
+    auto played = std::chrono::steady_clock::now() + std::chrono::milliseconds(sourceMs + config.endPauseMs + 500);
+    auto deadline = played + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline &&
+           (std::chrono::steady_clock::now() < played || recorder.isRecordingActive())) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    recorder.stop();
+
+    std::vector<std::string> files;
+    for (const auto& item : std::filesystem::directory_iterator(dir)) {
+        std::string file = item.path().filename().string();
+        if (file.rfind(name, 0) == 0 && item.path().extension() == ".wav") files.push_back(file);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static bool expect(const char* label, const std::vector<std::string>& files, size_t count, bool segmented) {
+    size_t numbered = 0;
+    for (const std::string& file : files) {
+        if (file.find("_1.wav") != std::string::npos || file.find("_2.wav") != std::string::npos) ++numbered;
+    }
+    bool ok = files.size() == count && (numbered > 0) == segmented;
+    std::printf("%s: %zu file(s), %zu numbered segment(s) - %s\n", label, files.size(), numbered, ok ? "ok" : "FAILED");
+    for (const std::string& file : files) {
+        std::printf("  %s\n", file.c_str());
+    }
+    return ok;
+}
+
+int main() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "course_split_check";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    RecorderConfig config;
+    config.backend = "mock";
+    config.channels = 1;
+    config.recordSeconds = 60;
+    config.splitPauseMs = 700;
+    config.endPauseMs = 2000;
+    config.journal = "";
+    config.recordingIndex = "";
+
+    bool ok = true;
+    // 1 s pauses: one recording, cut into three segments by the splitter
+    ok = expect("1 s pauses", record(dir, "pauses", bursts(config.sampleRate, 3, 1000, 1000), config), 3, true) && ok;
+    // 3 s pauses: every burst is a recording of its own
+    ok = expect("3 s pauses", record(dir, "ends", bursts(config.sampleRate, 2, 1000, 3000), config), 2, false) && ok;
+
+    std::filesystem::remove_all(dir);
+    return ok ? 0 : 1;
+}